@@ -0,0 +1,845 @@
+/*
+Benchmark harness for the four task programs.
+
+Generates synthetic monthly QA logs of a given size, number of production lines, Product ID and Issue Code
+cardinality, skew and presortedness, and times the original algorithms of the task programs (mergeSort, insertLog and
+generateReport, searchEarliestOccurrence, countIssues) together with the alternative engines added since, so that the
+O(N log N), O(N) and O(log N) claims of the file headers can be checked against real sizes.
+
+The task programs are compiled into the harness as they are, with their main functions renamed. Every result is
+appended as one CSV row to the results file for regression tracking: latency percentiles per operation, throughput in
+logs (or queries) per second and peak resident memory. Progress is written to stderr; standard output is discarded,
+since the report engines print their reports.
+
+Generated logs mimic a monthly export: the logs of each line are in date and time order and the lines follow one
+another. --presorted 0.9 then leaves 90% of the logs in place and moves the others to random positions, down to
+--presorted 0 for a random order. --skew is the exponent of a Zipf distribution of Product IDs and Issue Codes
+(0 for uniform).
+
+Build with -pthread -lm
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define main task1_main
+#include "task1_assignment.c"
+#undef main
+#define main task2_main
+#include "task2_assignment.c"
+#undef main
+#define main task3_main
+#include "task3_assignment.c"
+#undef main
+#define main task4_main
+#include "task4_assignment.c"
+#undef main
+
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#define BENCH_NULL_DEVICE "NUL"
+#else
+#include <sys/resource.h>
+#define BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+// Minutes in a 31-day month, the range of generated Batch Date & Time values
+#define BENCH_MONTH_MINUTES (31 * 24 * 60)
+
+// Queries are timed in batches of this many, since a single lookup is close to the timer resolution
+#define BENCH_QUERIES_PER_SAMPLE 64
+
+// The linear scans answer at most this many queries per size
+#define BENCH_SCAN_QUERIES 20
+
+#define BENCH_DEFAULT_SIZES "1000,10000,100000,1000000"
+#define BENCH_DEFAULT_RESULTS "benchmark_results.csv"
+
+// Define the shape of the generated logs and of the runs
+struct BenchConfig
+{
+    int lines;
+    int products;
+    int issues;
+    double skew;
+    double presorted;
+    int repeats;
+    int queries;
+    uint64_t seed;
+};
+
+// Define what every engine gets: the generated logs and the queries to answer
+struct BenchSetup
+{
+    const struct BenchConfig *config;
+    const struct LogStore *store;
+    const int *queries; // Product ID and Issue Code of each query, one after the other
+    int query_count;
+};
+
+// Define the timings of one engine at one size
+struct BenchSamples
+{
+    double *us;          // Microseconds per operation of each sample
+    int count;
+    int capacity;
+    double total_ms;
+    int64_t operations;
+    int64_t items;       // Logs or queries processed
+};
+
+// Define an engine of the benchmark: the operation it times and the largest size it is run at
+struct BenchEngine
+{
+    const char *name;
+    const char *operation;
+    int max_size;
+    int (*run)(const struct BenchSetup *setup, struct BenchSamples *samples);
+};
+
+// Keeps the compiler from dropping lookups whose results are otherwise unused
+volatile int64_t bench_sink;
+
+
+// Function to record one timed sample covering operations operations over items logs or queries
+// Returns 0 if memory could not be allocated
+int addBenchSample(struct BenchSamples *samples, double elapsed_ms, int operations, int64_t items)
+{
+    if (samples->count == samples->capacity)
+    {
+        int capacity = samples->capacity > 0 ? 2 * samples->capacity : 64;
+        double *grown = (double *)realloc(samples->us, (size_t)capacity * sizeof(double));
+        if (grown == NULL)
+        {
+            return 0;
+        }
+        samples->us = grown;
+        samples->capacity = capacity;
+    }
+
+    samples->us[samples->count++] = elapsed_ms * 1000.0 / operations;
+    samples->total_ms += elapsed_ms;
+    samples->operations += operations;
+    samples->items += items;
+    return 1;
+}
+
+
+// qsort comparison for sample times
+int compareSamples(const void *a, const void *b)
+{
+    double left = *(const double *)a;
+    double right = *(const double *)b;
+    return (left > right) - (left < right);
+}
+
+
+// Function to read a percentile from sorted samples
+double samplePercentile(const double sorted[], int count, double percentile)
+{
+    int position = (int)ceil(percentile / 100.0 * count) - 1;
+    return sorted[position < 0 ? 0 : position];
+}
+
+
+// Function to forget the peak resident memory so far, where the system allows it
+void resetPeakRss(void)
+{
+#ifdef __linux__
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+    if (file != NULL)
+    {
+        fputs("5", file);
+        fclose(file);
+    }
+#endif
+}
+
+
+// Function to read the peak resident memory in kilobytes since the last reset (or since the start)
+long peakRssKb(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? (long)(counters.PeakWorkingSetSize / 1024) : -1;
+#else
+#ifdef __linux__
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file != NULL)
+    {
+        char line[256];
+        long peak = -1;
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+            {
+                peak = strtol(line + 6, NULL, 10);
+                break;
+            }
+        }
+        fclose(file);
+        if (peak >= 0)
+        {
+            return peak;
+        }
+    }
+#endif
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? (long)usage.ru_maxrss : -1;
+#endif
+}
+
+
+// Function to draw a uniform number in [0, 1)
+double nextUniform(uint64_t *random_state)
+{
+    return (double)(nextRandom(random_state) >> 11) / (double)(1ULL << 53);
+}
+
+
+// Function to build the cumulative Zipf distribution of exponent skew over count values
+// Returns the array (to be freed by the caller), or NULL if memory could not be allocated
+double *buildZipfTable(int count, double skew)
+{
+    double *cumulative = (double *)malloc((size_t)count * sizeof(double));
+    if (cumulative == NULL)
+    {
+        return NULL;
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        total += 1.0 / pow(i + 1, skew);
+        cumulative[i] = total;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        cumulative[i] /= total;
+    }
+    return cumulative;
+}
+
+
+// Function to draw a value from 0 to count - 1 from a cumulative distribution
+int drawZipf(const double cumulative[], int count, uint64_t *random_state)
+{
+    double target = nextUniform(random_state);
+    int left = 0;
+    int right = count - 1;
+    while (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        if (cumulative[mid] < target)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+
+// Function to append logs_number synthetic logs shaped by config to the store
+// Returns 0 if memory could not be allocated
+int generateBenchLogs(struct LogStore *store, int logs_number, const struct BenchConfig *config, uint64_t *random_state)
+{
+    double *products = buildZipfTable(config->products, config->skew);
+    double *issues = buildZipfTable(config->issues, config->skew);
+    int ok = products != NULL && issues != NULL && reserveLogStore(store, store->size + logs_number);
+
+    // Each line logs its share of the month in date and time order
+    struct ProductionLine_Log log;
+    int first_row = store->size;
+    for (int line = 0; ok && line < config->lines; line++)
+    {
+        int line_logs = logs_number / config->lines + (line < logs_number % config->lines);
+        for (int i = 0; ok && i < line_logs; i++)
+        {
+            int minute = (int)((int64_t)i * BENCH_MONTH_MINUTES / line_logs);
+            log.LineCode = line + 1;
+            log.BatchCode = 100 + (int)(nextRandom(random_state) % 900);
+            log.BatchDateTime.dayofmonth = 1 + minute / (24 * 60);
+            log.BatchDateTime.hourofday = minute / 60 % 24;
+            log.BatchDateTime.minuteofhour = minute % 60;
+            log.ProductId = 1000 + drawZipf(products, config->products, random_state);
+            log.IssueCode = 1 + drawZipf(issues, config->issues, random_state);
+            log.ResolutionCode = log.IssueCode;
+            log.ReportingEmployeeId = 100 + (int)(nextRandom(random_state) % 10);
+            snprintf(log.IssueDescription, sizeof(log.IssueDescription), "Issue %d", log.IssueCode);
+            snprintf(log.ResolutionDescription, sizeof(log.ResolutionDescription), "Resolution %d", log.ResolutionCode);
+            ok = appendLog(store, &log);
+        }
+    }
+
+    // Move the logs that are not presorted to random positions
+    int *order = ok ? (int *)malloc((size_t)(logs_number > 0 ? logs_number : 1) * sizeof(int)) : NULL;
+    ok = ok && order != NULL;
+    if (ok && config->presorted < 1.0 && logs_number > 1)
+    {
+        for (int i = 0; i < logs_number; i++)
+        {
+            order[i] = first_row + i;
+        }
+        int64_t moves = (int64_t)((1.0 - config->presorted) * logs_number);
+        for (int64_t m = 0; m < moves; m++)
+        {
+            int a = (int)(nextRandom(random_state) % (uint64_t)logs_number);
+            int b = (int)(nextRandom(random_state) % (uint64_t)logs_number);
+            int swap = order[a];
+            order[a] = order[b];
+            order[b] = swap;
+        }
+
+        // permuteLogStore() reorders whole stores, so the generated rows are expected to be the only ones
+        ok = first_row == 0 && permuteLogStore(store, order);
+    }
+
+    free(order);
+    free(products);
+    free(issues);
+    return ok;
+}
+
+
+// Function to make the lookups answered by the search and count engines: every other query asks for the
+// Product ID and Issue Code of an existing log, the others for random codes, some of them absent
+// Returns the array (to be freed by the caller), or NULL if memory could not be allocated
+int *generateBenchQueries(const struct LogStore *store, int query_count, const struct BenchConfig *config, uint64_t *random_state)
+{
+    int *queries = (int *)malloc(2 * (size_t)query_count * sizeof(int));
+    if (queries == NULL)
+    {
+        return NULL;
+    }
+
+    for (int q = 0; q < query_count; q++)
+    {
+        if (q % 2 == 0 && store->size > 0)
+        {
+            int row = (int)(nextRandom(random_state) % (uint64_t)store->size);
+            queries[2 * q] = store->ProductId[row];
+            queries[2 * q + 1] = store->IssueCode[row];
+        }
+        else
+        {
+            queries[2 * q] = 1000 + (int)(nextRandom(random_state) % (uint64_t)(config->products + config->products / 10 + 1));
+            queries[2 * q + 1] = 1 + (int)(nextRandom(random_state) % (uint64_t)(config->issues + 1));
+        }
+    }
+    return queries;
+}
+
+
+// Function to copy the logs of a store into an empty store, so that an engine can sort its own copy
+int copyBenchStore(struct LogStore *copy, const struct LogStore *store)
+{
+    initLogStore(copy);
+    if (!appendLogStore(copy, store))
+    {
+        freeLogStore(copy);
+        return 0;
+    }
+    return 1;
+}
+
+
+// Engine: task1 mergeSort on full records
+int benchMergeSort(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int size = setup->store->size;
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct ProductionLine_Log *logs_data = copyLogRecords(setup->store);
+        ok = logs_data != NULL;
+        if (ok)
+        {
+            double start = currentTimeMs();
+            ok = mergeSort(logs_data, 0, size - 1);
+            double elapsed_ms = currentTimeMs() - start;
+            ok = ok && addBenchSample(samples, elapsed_ms, 1, size);
+        }
+        free(logs_data);
+    }
+    return ok;
+}
+
+
+// Function to time one store-sorting engine of task1 on copies of the logs
+int benchStoreSort(const struct BenchSetup *setup, struct BenchSamples *samples, EntrySortFunction sort_entries, int thread_count)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct LogStore copy;
+        ok = copyBenchStore(&copy, setup->store);
+        if (!ok)
+        {
+            break;
+        }
+
+        double start = currentTimeMs();
+        ok = thread_count > 0 ? parallelIndexSort(&copy, thread_count) : indexSort(&copy, sort_entries);
+        double elapsed_ms = currentTimeMs() - start;
+
+        ok = ok && addBenchSample(samples, elapsed_ms, 1, copy.size);
+        freeLogStore(&copy);
+    }
+    return ok;
+}
+
+
+// Engines: task1 index, radix, adaptive and parallel sorts of the store
+int benchIndexSort(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchStoreSort(setup, samples, sortEntries, 0);
+}
+
+int benchRadixSort(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchStoreSort(setup, samples, radixSortEntries, 0);
+}
+
+int benchAdaptiveSort(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchStoreSort(setup, samples, adaptiveSortEntries, 0);
+}
+
+int benchParallelSort(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchStoreSort(setup, samples, NULL, defaultThreadCount());
+}
+
+
+// Engine: task1 external sort, printing its report to the discarded standard output
+int benchExternalSort(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        double start = currentTimeMs();
+        ok = externalSortReport(setup->store, (size_t)EXTERNAL_DEFAULT_BUDGET_MB << 20, REPORT_TEXT) == 1;
+        fflush(stdout);
+        ok = ok && addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+    }
+    return ok;
+}
+
+
+// Engine: task2 insertLog for every log, O(N^2)
+int benchInsertLog(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct NodeArena arena = {NULL};
+        struct Node *head = NULL;
+        double start = currentTimeMs();
+        for (int i = 0; i < setup->store->size; i++)
+        {
+            insertLog(&arena, &head, setup->store, i);
+        }
+        ok = addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+        freeNodeArena(&arena);
+    }
+    return ok;
+}
+
+
+// Engine: task2 buildGroupedList
+int benchGroupedList(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct NodeArena arena = {NULL};
+        double start = currentTimeMs();
+        ok = buildGroupedList(&arena, setup->store) != NULL || setup->store->size == 0;
+        ok = ok && addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+        freeNodeArena(&arena);
+    }
+    return ok;
+}
+
+
+// Engine: task2 live list built one appended log at a time
+int benchLiveList(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct LiveList list;
+        memset(&list, 0, sizeof(struct LiveList));
+        double start = currentTimeMs();
+        for (int i = 0; ok && i < setup->store->size; i++)
+        {
+            ok = addLiveLog(&list, setup->store, i);
+        }
+        ok = ok && addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+        freeLiveList(&list);
+    }
+    return ok;
+}
+
+
+// Engine: task2 generateReport over the grouped list, printing to the discarded standard output
+int benchGenerateReport(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    struct NodeArena arena = {NULL};
+    struct Node *head = buildGroupedList(&arena, setup->store);
+    int ok = head != NULL || setup->store->size == 0;
+
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        double start = currentTimeMs();
+        generateReport(setup->store, head, REPORT_TEXT);
+        fflush(stdout);
+        ok = addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+    }
+
+    freeNodeArena(&arena);
+    return ok;
+}
+
+
+// Engine: task3 buildSearchIndex
+int benchBuildSearchIndex(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct SearchIndex index;
+        double start = currentTimeMs();
+        ok = buildSearchIndex(&index, setup->store);
+        ok = ok && addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+        if (ok)
+        {
+            freeSearchIndex(&index);
+        }
+    }
+    return ok;
+}
+
+
+// Engines: task3 searchEarliestOccurrence on the sorted index and searchEarliestEytzinger, timed per query
+int benchIndexedSearch(const struct BenchSetup *setup, struct BenchSamples *samples, int eytzinger_layout)
+{
+    struct SearchIndex index;
+    struct EytzingerIndex eytzinger = {NULL, NULL, 0};
+    if (!buildSearchIndex(&index, setup->store))
+    {
+        return 0;
+    }
+    int ok = !eytzinger_layout || buildEytzingerIndex(&eytzinger, &index);
+
+    for (int first = 0; ok && first < setup->query_count; first += BENCH_QUERIES_PER_SAMPLE)
+    {
+        int last = first + BENCH_QUERIES_PER_SAMPLE < setup->query_count ? first + BENCH_QUERIES_PER_SAMPLE : setup->query_count;
+        int64_t found = 0;
+        double start = currentTimeMs();
+        for (int q = first; q < last; q++)
+        {
+            found += eytzinger_layout ? searchEarliestEytzinger(&eytzinger, setup->queries[2 * q], setup->queries[2 * q + 1])
+                                      : searchEarliestOccurrence(&index, setup->queries[2 * q], setup->queries[2 * q + 1]);
+        }
+        double elapsed_ms = currentTimeMs() - start;
+        bench_sink += found;
+        ok = addBenchSample(samples, elapsed_ms, last - first, last - first);
+    }
+
+    if (eytzinger_layout)
+    {
+        freeEytzingerIndex(&eytzinger);
+    }
+    freeSearchIndex(&index);
+    return ok;
+}
+
+int benchSortedSearch(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchIndexedSearch(setup, samples, 0);
+}
+
+int benchEytzingerSearch(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchIndexedSearch(setup, samples, 1);
+}
+
+
+// Engine: task3 linear scan for the earliest occurrence, timed per query
+int benchLinearSearch(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int queries = setup->query_count < BENCH_SCAN_QUERIES ? setup->query_count : BENCH_SCAN_QUERIES;
+    int ok = 1;
+    for (int q = 0; ok && q < queries; q++)
+    {
+        double start = currentTimeMs();
+        bench_sink += linearEarliestOccurrence(setup->store, setup->queries[2 * q], setup->queries[2 * q + 1]);
+        ok = addBenchSample(samples, currentTimeMs() - start, 1, 1);
+    }
+    return ok;
+}
+
+
+// Engines: task4 countIssues and countIssuesColumnar, timed per query
+int benchCountScan(const struct BenchSetup *setup, struct BenchSamples *samples, int columnar)
+{
+    struct CountKernel kernel = selectCountKernel();
+    int queries = setup->query_count < BENCH_SCAN_QUERIES ? setup->query_count : BENCH_SCAN_QUERIES;
+    int ok = 1;
+    for (int q = 0; ok && q < queries; q++)
+    {
+        double start = currentTimeMs();
+        bench_sink += columnar ? countIssuesColumnar(setup->store, kernel, setup->queries[2 * q])
+                               : countIssues(setup->store, setup->queries[2 * q]);
+        ok = addBenchSample(samples, currentTimeMs() - start, 1, 1);
+    }
+    return ok;
+}
+
+int benchCountIssues(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchCountScan(setup, samples, 0);
+}
+
+int benchCountColumnar(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    return benchCountScan(setup, samples, 1);
+}
+
+
+// Engine: task4 buildIssueSummary with both breakdowns
+int benchIssueSummary(const struct BenchSetup *setup, struct BenchSamples *samples)
+{
+    int ok = 1;
+    for (int r = 0; ok && r < setup->config->repeats; r++)
+    {
+        struct IssueSummary summary;
+        double start = currentTimeMs();
+        ok = buildIssueSummary(&summary, setup->store, 1, 1);
+        ok = ok && addBenchSample(samples, currentTimeMs() - start, 1, setup->store->size);
+        if (ok)
+        {
+            freeIssueSummary(&summary);
+        }
+    }
+    return ok;
+}
+
+
+// The engines in the order they are run; max_size keeps the quadratic and per-query linear engines, and mergeSort with
+// its full-record copies, to sizes that finish in reasonable time
+const struct BenchEngine bench_engines[] =
+{
+    {"task1.merge", "sort", 1000000, benchMergeSort},
+    {"task1.index", "sort", INT32_MAX, benchIndexSort},
+    {"task1.radix", "sort", INT32_MAX, benchRadixSort},
+    {"task1.adaptive", "sort", INT32_MAX, benchAdaptiveSort},
+    {"task1.parallel", "sort", INT32_MAX, benchParallelSort},
+    {"task1.external", "sort+report", INT32_MAX, benchExternalSort},
+    {"task2.insert", "build", 20000, benchInsertLog},
+    {"task2.bucket", "build", INT32_MAX, benchGroupedList},
+    {"task2.live", "build", INT32_MAX, benchLiveList},
+    {"task2.report", "report", INT32_MAX, benchGenerateReport},
+    {"task3.index", "build", INT32_MAX, benchBuildSearchIndex},
+    {"task3.sorted", "query", INT32_MAX, benchSortedSearch},
+    {"task3.eytzinger", "query", INT32_MAX, benchEytzingerSearch},
+    {"task3.linear", "query", 10000000, benchLinearSearch},
+    {"task4.count", "query", INT32_MAX, benchCountIssues},
+    {"task4.columnar", "query", INT32_MAX, benchCountColumnar},
+    {"task4.summary", "build", INT32_MAX, benchIssueSummary},
+};
+
+
+// Function to check whether an engine is selected by a comma-separated list of names or name prefixes (NULL for all)
+int engineSelected(const char *name, const char *selection)
+{
+    if (selection == NULL)
+    {
+        return 1;
+    }
+
+    const char *item = selection;
+    while (*item != '\0')
+    {
+        size_t length = strcspn(item, ",");
+        if (length > 0 && strncmp(name, item, length) == 0 && (name[length] == '\0' || name[length] == '.'))
+        {
+            return 1;
+        }
+        item += length + (item[length] == ',');
+    }
+    return 0;
+}
+
+
+// Function to parse a comma-separated list of sizes such as 1000,1e6 into sizes[]
+// Returns the number of sizes, or 0 if a size is not between 1 and INT32_MAX
+int parseSizes(const char *text, int sizes[], int max_sizes)
+{
+    int count = 0;
+    while (*text != '\0' && count < max_sizes)
+    {
+        char *end;
+        double size = strtod(text, &end);
+        if (end == text || size < 1 || size > INT32_MAX || (*end != ',' && *end != '\0'))
+        {
+            return 0;
+        }
+        sizes[count++] = (int)size;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+
+// Function to append the results of one engine at one size to the results file
+void writeBenchRow(FILE *results, long run_id, const struct BenchEngine *engine, const struct BenchConfig *config,
+                   int size, struct BenchSamples *samples, long peak_rss_kb)
+{
+    qsort(samples->us, (size_t)samples->count, sizeof(double), compareSamples);
+    double items_per_second = samples->total_ms > 0 ? samples->items * 1000.0 / samples->total_ms : 0.0;
+
+    fprintf(results, "%ld,%s,%s,%d,%d,%d,%d,%.3f,%.3f,%lld,%.3f,%.1f,%.3f,%.3f,%.3f,%.3f,%ld\n",
+            run_id, engine->name, engine->operation, size, config->lines, config->products, config->issues,
+            config->skew, config->presorted, (long long)samples->operations, samples->total_ms, items_per_second,
+            samplePercentile(samples->us, samples->count, 50), samplePercentile(samples->us, samples->count, 90),
+            samplePercentile(samples->us, samples->count, 99), samples->us[samples->count - 1], peak_rss_kb);
+    fflush(results);
+}
+
+
+// Usage: benchmark [--sizes 1000,10000,...] [--lines n] [--products n] [--issues n] [--skew s] [--presorted p]
+//                  [--repeats n] [--queries n] [--seed n] [--engines name,...] [--out results.csv]
+// --sizes     - numbers of logs to run at, 1e3 to 1e8 (default 1000,10000,100000,1000000)
+// --lines     - production lines (default 4)
+// --products  - distinct Product IDs (default 1000) and --issues distinct Issue Codes (default 50)
+// --skew      - Zipf exponent of the Product ID and Issue Code distributions (default 0, uniform)
+// --presorted - fraction of logs left in per-line date and time order (default 1)
+// --repeats   - timed runs of each sort or build (default 5); --queries lookups per query engine (default 100000)
+// --engines   - engines or task prefixes to run, for example task1,task3.sorted (default all)
+// --out       - CSV file the results are appended to (default benchmark_results.csv)
+int main(int argc, char *argv[])
+{
+    struct BenchConfig config = {4, 1000, 50, 0.0, 1.0, 5, 100000, 88172645463325252ULL};
+    const char *sizes_text = BENCH_DEFAULT_SIZES;
+    const char *engines = NULL;
+    const char *results_path = BENCH_DEFAULT_RESULTS;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const char *option = argv[i];
+        const char *value = argv[i + 1];
+        if (strcmp(option, "--sizes") == 0) sizes_text = value;
+        else if (strcmp(option, "--lines") == 0) config.lines = atoi(value);
+        else if (strcmp(option, "--products") == 0) config.products = atoi(value);
+        else if (strcmp(option, "--issues") == 0) config.issues = atoi(value);
+        else if (strcmp(option, "--skew") == 0) config.skew = atof(value);
+        else if (strcmp(option, "--presorted") == 0) config.presorted = atof(value);
+        else if (strcmp(option, "--repeats") == 0) config.repeats = atoi(value);
+        else if (strcmp(option, "--queries") == 0) config.queries = atoi(value);
+        else if (strcmp(option, "--seed") == 0) config.seed = strtoull(value, NULL, 10);
+        else if (strcmp(option, "--engines") == 0) engines = value;
+        else if (strcmp(option, "--out") == 0) results_path = value;
+        else
+        {
+            printf("Unknown option: %s\n", option);
+            return 1;
+        }
+    }
+
+    int sizes[64];
+    int size_count = parseSizes(sizes_text, sizes, 64);
+    if (argc % 2 == 0 || size_count == 0 || config.lines < 1 || config.lines > 31 || config.products < 1 ||
+        config.products > LOG_KEY_FIELD_LIMIT - 1000 || config.issues < 1 || config.issues >= LOG_KEY_FIELD_LIMIT ||
+        config.skew < 0 || config.presorted < 0 || config.presorted > 1 || config.repeats < 1 || config.queries < 1 ||
+        config.seed == 0)
+    {
+        fprintf(stderr, "Usage: %s [--sizes 1000,10000,...] [--lines n] [--products n] [--issues n] [--skew s] [--presorted p]\n"
+                        "       [--repeats n] [--queries n] [--seed n] [--engines name,...] [--out results.csv]\n", argv[0]);
+        return 1;
+    }
+
+    // Add the header when the results file is new
+    FILE *results = fopen(results_path, "a");
+    if (results == NULL)
+    {
+        fprintf(stderr, "Could not open results file %s.\n", results_path);
+        return 1;
+    }
+    if (ftell(results) == 0)
+    {
+        fprintf(results, "run_id,engine,operation,size,lines,products,issues,skew,presorted,operations,total_ms,"
+                         "items_per_second,p50_us,p90_us,p99_us,max_us,peak_rss_kb\n");
+    }
+
+    // The report engines print their reports; nothing else is written to standard output
+    if (freopen(BENCH_NULL_DEVICE, "w", stdout) == NULL)
+    {
+        fprintf(stderr, "Could not discard standard output.\n");
+        fclose(results);
+        return 1;
+    }
+
+    long run_id = (long)time(NULL);
+    int status = 0;
+    for (int s = 0; s < size_count; s++)
+    {
+        // Generate the logs and queries of this size once for all engines
+        struct LogStore store;
+        initLogStore(&store);
+        uint64_t random_state = config.seed;
+        double start = currentTimeMs();
+        int *queries = NULL;
+        if (!generateBenchLogs(&store, sizes[s], &config, &random_state) ||
+            (queries = generateBenchQueries(&store, config.queries, &config, &random_state)) == NULL)
+        {
+            fprintf(stderr, "Could not generate %d logs.\n", sizes[s]);
+            freeLogStore(&store);
+            status = 1;
+            break;
+        }
+        fprintf(stderr, "Generated %d logs in %.3f ms\n", sizes[s], currentTimeMs() - start);
+
+        struct BenchSetup setup = {&config, &store, queries, config.queries};
+        for (size_t e = 0; e < sizeof(bench_engines) / sizeof(bench_engines[0]); e++)
+        {
+            const struct BenchEngine *engine = &bench_engines[e];
+            if (!engineSelected(engine->name, engines) || sizes[s] > engine->max_size)
+            {
+                continue;
+            }
+
+            struct BenchSamples samples;
+            memset(&samples, 0, sizeof(struct BenchSamples));
+            resetPeakRss();
+
+            if (engine->run(&setup, &samples) && samples.count > 0)
+            {
+                writeBenchRow(results, run_id, engine, &config, sizes[s], &samples, peakRssKb());
+                fprintf(stderr, "%-16s %10d logs  %12.3f ms  p50 %.3f us\n", engine->name, sizes[s], samples.total_ms,
+                        samplePercentile(samples.us, samples.count, 50));
+            }
+            else
+            {
+                fprintf(stderr, "%-16s %10d logs  failed\n", engine->name, sizes[s]);
+                status = 1;
+            }
+            free(samples.us);
+        }
+
+        free(queries);
+        freeLogStore(&store);
+    }
+
+    fclose(results);
+    return status;
+}
@@ -0,0 +1,578 @@
+/*
+Month-partitioned archive of QA logs.
+
+The QA logs are created anew each month; the archive keeps every month as its own partition so that questions can
+be asked across years of logs, such as the earliest occurrence ever of an issue code for a product. A partition is
+a .qalog file (see qa_log_file.h) whose logs are sorted by packed log key, that is by Product ID, Issue Code and
+Batch Date & Time, so a mapped partition is searched with binary searches directly over its columns and is never
+loaded or indexed.
+
+The archive is described by a small text manifest, one line per month:
+
+    2024-03 1000000 1000 1999 2024-03.qalog
+
+giving the month, the number of logs, the lowest and highest Product ID and the partition file, relative to the
+directory of the manifest. A query reads only the manifest, prunes the months whose Product ID range (or date, for
+a month range) cannot match, and fans the remaining months out over a pool of threads which map and search their
+partitions; the partial results are then merged. The earliest-occurrence search takes months in date order and
+skips every month later than the earliest match found so far.
+Build with -pthread.
+*/
+
+#ifndef QA_ARCHIVE_H
+#define QA_ARCHIVE_H
+
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_sort_key.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define ARCHIVE_MAX_PATH 1024
+#define ARCHIVE_MANIFEST_LINE 2048
+
+// Define one month of the archive, as described by its manifest line
+struct ArchivePartition
+{
+    int month;         // year * 12 + month - 1
+    int rows;
+    int min_product;
+    int max_product;
+    char path[ARCHIVE_MAX_PATH];
+    struct LogStore store; // Mapped when the partition is first searched
+    int opened;
+};
+
+// Define a month-partitioned archive, its partitions in month order
+struct LogArchive
+{
+    struct ArchivePartition *partitions;
+    int count;
+};
+
+// Define a query run over the partitions of an archive by a pool of threads
+// Task t searches partition candidates[t]; the threads take tasks in order from next
+struct ArchiveQuery
+{
+    struct LogArchive *archive;
+    const int *candidates;
+    int candidate_count;
+    atomic_int next;
+    void (*run)(void *context, struct ArchivePartition *partition, int task);
+    void *context;
+};
+
+// Define the state of an earliest-occurrence search across the archive
+struct ArchiveEarliest
+{
+    int productID;
+    int issueCode;
+    int *rows;              // Earliest row found in each task's partition, -1 for none
+    atomic_int best_month;  // Earliest month with a match so far
+    atomic_int failed;
+};
+
+// Define the state of an issue count across the archive
+struct ArchiveCount
+{
+    int productID;
+    int *counts;            // Count of each task's partition
+    atomic_int failed;
+};
+
+
+// Function to parse a month written YYYY-MM
+// Returns year * 12 + month - 1, or -1 if the text is not a month
+static inline int parseArchiveMonth(const char *text)
+{
+    int year;
+    int month;
+    char rest;
+    if (sscanf(text, "%4d-%2d%c", &year, &month, &rest) != 2 || year < 1 || month < 1 || month > 12)
+    {
+        return -1;
+    }
+    return year * 12 + month - 1;
+}
+
+
+// Function to write a month as YYYY-MM into text, which holds at least 16 characters
+static inline void formatArchiveMonth(int month, char text[])
+{
+    snprintf(text, 16, "%04d-%02d", month / 12, month % 12 + 1);
+}
+
+
+// Function to join the directory of the manifest and a partition file name into path
+// Returns 0 and prints the reason if the joined path does not fit into ARCHIVE_MAX_PATH characters
+static inline int archivePartitionPath(const char *manifest_path, const char *file_name, char path[])
+{
+    const char *slash = strrchr(manifest_path, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(manifest_path, '\\');
+    slash = backslash != NULL && (slash == NULL || backslash > slash) ? backslash : slash;
+#endif
+    size_t directory_length = slash != NULL ? (size_t)(slash - manifest_path + 1) : 0;
+    size_t name_length = strlen(file_name);
+    if (directory_length + name_length >= ARCHIVE_MAX_PATH)
+    {
+        printf("Path of archive partition %s is too long.\n", file_name);
+        return 0;
+    }
+    memcpy(path, manifest_path, directory_length);
+    memcpy(path + directory_length, file_name, name_length + 1);
+    return 1;
+}
+
+
+// Function to release an archive and unmap its partitions
+static inline void freeArchive(struct LogArchive *archive)
+{
+    for (int p = 0; p < archive->count; p++)
+    {
+        freeLogStore(&archive->partitions[p].store);
+    }
+    free(archive->partitions);
+    archive->partitions = NULL;
+    archive->count = 0;
+}
+
+
+// qsort comparison ordering partitions by month
+static inline int compareArchivePartitions(const void *a, const void *b)
+{
+    const struct ArchivePartition *left = (const struct ArchivePartition *)a;
+    const struct ArchivePartition *right = (const struct ArchivePartition *)b;
+    return (left->month > right->month) - (left->month < right->month);
+}
+
+
+// Function to read the manifest of an archive; no partition is opened
+// A missing manifest gives an empty archive when missing_ok is set
+// Returns 0 and prints the reason if the manifest could not be read or is not valid
+static inline int loadArchive(struct LogArchive *archive, const char *manifest_path, int missing_ok)
+{
+    archive->partitions = NULL;
+    archive->count = 0;
+
+    FILE *file = fopen(manifest_path, "r");
+    if (file == NULL)
+    {
+        if (!missing_ok)
+        {
+            printf("Could not open archive manifest %s.\n", manifest_path);
+        }
+        return missing_ok;
+    }
+
+    int capacity = 0;
+    int line_number = 0;
+    int status = 1;
+    char line[ARCHIVE_MANIFEST_LINE];
+    while (status && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+        char month_text[16];
+        char file_name[ARCHIVE_MAX_PATH];
+        struct ArchivePartition partition;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0')
+        {
+            continue;
+        }
+        if (sscanf(line, "%15s %d %d %d %1023s", month_text, &partition.rows, &partition.min_product,
+                   &partition.max_product, file_name) != 5 ||
+            (partition.month = parseArchiveMonth(month_text)) < 0)
+        {
+            printf("Line %d of archive manifest %s is not valid.\n", line_number, manifest_path);
+            status = 0;
+            break;
+        }
+
+        if (archive->count == capacity)
+        {
+            capacity = capacity > 0 ? 2 * capacity : 16;
+            struct ArchivePartition *grown = (struct ArchivePartition *)realloc(archive->partitions, (size_t)capacity * sizeof(struct ArchivePartition));
+            if (grown == NULL)
+            {
+                printf("Memory allocation failed.\n");
+                status = 0;
+                break;
+            }
+            archive->partitions = grown;
+        }
+        if (!archivePartitionPath(manifest_path, file_name, partition.path))
+        {
+            status = 0;
+            break;
+        }
+        initLogStore(&partition.store);
+        partition.opened = 0;
+        archive->partitions[archive->count++] = partition;
+    }
+    fclose(file);
+
+    if (!status)
+    {
+        freeArchive(archive);
+        return 0;
+    }
+    qsort(archive->partitions, (size_t)archive->count, sizeof(struct ArchivePartition), compareArchivePartitions);
+    return 1;
+}
+
+
+// Function to sort the logs of the store by packed log key, the order of an archive partition
+// Returns 0 and prints the reason if a log does not fit into a packed key or memory could not be allocated
+static inline int sortArchiveLogs(struct LogStore *store)
+{
+    // A mapped store is moved onto the heap before it is reordered
+    if (store->mapping != NULL && !detachLogStore(store, store->size))
+    {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+
+    int size = store->size;
+    int *order = (int *)malloc((size_t)(size > 0 ? size : 1) * sizeof(int));
+    if (order == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+    struct SortEntry *entries = sortLogKeyEntries(store, "archived");
+    if (entries == NULL)
+    {
+        free(order);
+        return 0;
+    }
+    for (int i = 0; i < size; i++)
+    {
+        order[i] = entries[i].index;
+    }
+
+    int sorted = permuteLogStore(store, order);
+    if (!sorted)
+    {
+        printf("Memory allocation failed.\n");
+    }
+    free(entries);
+    free(order);
+    return sorted;
+}
+
+
+// Function to add a month of logs to an archive: the logs are sorted, written next to the manifest as YYYY-MM.qalog
+// and described by a new manifest line (the manifest is created if needed)
+// Returns 0 and prints the reason if the month is already archived or the logs could not be written
+static inline int addArchiveMonth(const char *manifest_path, int month, struct LogStore *store)
+{
+    struct LogArchive archive;
+    if (!loadArchive(&archive, manifest_path, 1))
+    {
+        return 0;
+    }
+
+    char month_text[16];
+    formatArchiveMonth(month, month_text);
+    for (int p = 0; p < archive.count; p++)
+    {
+        if (archive.partitions[p].month == month)
+        {
+            printf("Month %s is already in archive %s.\n", month_text, manifest_path);
+            freeArchive(&archive);
+            return 0;
+        }
+    }
+    int first_partition = archive.count == 0;
+    freeArchive(&archive);
+
+    if (!sortArchiveLogs(store))
+    {
+        return 0;
+    }
+    int min_product = store->size > 0 ? INT_MAX : 0;
+    int max_product = store->size > 0 ? INT_MIN : -1;
+    if (store->size > 0)
+    {
+        // The logs are sorted by Product ID first
+        min_product = store->ProductId[0];
+        max_product = store->ProductId[store->size - 1];
+    }
+
+    char file_name[32];
+    char path[ARCHIVE_MAX_PATH];
+    snprintf(file_name, sizeof(file_name), "%s.qalog", month_text);
+    if (!archivePartitionPath(manifest_path, file_name, path) || !writeLogFile(store, path))
+    {
+        return 0;
+    }
+
+    FILE *manifest = fopen(manifest_path, "a");
+    if (manifest == NULL)
+    {
+        printf("Could not open archive manifest %s.\n", manifest_path);
+        return 0;
+    }
+    if (first_partition && ftell(manifest) == 0)
+    {
+        fprintf(manifest, "# month logs min_product max_product file\n");
+    }
+    fprintf(manifest, "%s %d %d %d %s\n", month_text, store->size, min_product, max_product, file_name);
+    return fclose(manifest) == 0;
+}
+
+
+// Function to map an archive partition the first time it is searched
+// Returns 0 if its file could not be mapped or does not match the manifest
+static inline int openArchivePartition(struct ArchivePartition *partition)
+{
+    if (!partition->opened)
+    {
+        if (!mapLogFile(&partition->store, partition->path))
+        {
+            return 0;
+        }
+        if (partition->store.size != partition->rows)
+        {
+            printf("%s does not hold the %d logs listed in the archive manifest.\n", partition->path, partition->rows);
+            freeLogStore(&partition->store);
+            return 0;
+        }
+        partition->opened = 1;
+    }
+    return 1;
+}
+
+
+// Function to find the first log of a sorted partition whose packed key is not less than key, in O(log N)
+static inline int partitionLowerBound(const struct LogStore *store, uint64_t key)
+{
+    int left = 0;
+    int right = store->size;
+    while (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        if (productIssueOrderKey(store, mid) < key)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+
+// Function to list the partitions that may hold logs of productID in months first_month to last_month
+// (INT_MIN and INT_MAX for no bound) into candidates[], in month order
+// Returns the number of partitions left after pruning
+static inline int selectArchivePartitions(const struct LogArchive *archive, int productID, int first_month, int last_month, int candidates[])
+{
+    int count = 0;
+    for (int p = 0; p < archive->count; p++)
+    {
+        const struct ArchivePartition *partition = &archive->partitions[p];
+        if (partition->rows > 0 && partition->min_product <= productID && productID <= partition->max_product &&
+            partition->month >= first_month && partition->month <= last_month)
+        {
+            candidates[count++] = p;
+        }
+    }
+    return count;
+}
+
+
+// Worker loop of an archive query: take the next task until there are none left
+static inline void *archiveQueryWorker(void *argument)
+{
+    struct ArchiveQuery *query = (struct ArchiveQuery *)argument;
+    int task;
+    while ((task = atomic_fetch_add(&query->next, 1)) < query->candidate_count)
+    {
+        query->run(query->context, &query->archive->partitions[query->candidates[task]], task);
+    }
+    return NULL;
+}
+
+
+// Function to run one task per candidate partition on thread_count threads, the calling thread being one of them
+// Tasks are started in candidate order; if a thread fails to start, the others run its share
+static inline void runArchiveQuery(struct ArchiveQuery *query, int thread_count)
+{
+    thread_count = thread_count < query->candidate_count ? thread_count : query->candidate_count;
+    pthread_t *threads = (pthread_t *)malloc((size_t)(thread_count > 0 ? thread_count : 1) * sizeof(pthread_t));
+    int started = 0;
+    atomic_init(&query->next, 0);
+
+    while (threads != NULL && started + 1 < thread_count &&
+           pthread_create(&threads[started], NULL, archiveQueryWorker, query) == 0)
+    {
+        started++;
+    }
+    archiveQueryWorker(query);
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+}
+
+
+// Archive query task: find the earliest occurrence of the issue code for the product in one partition
+// Partitions of a later month than a match already found are skipped
+static inline void findEarliestInPartition(void *context, struct ArchivePartition *partition, int task)
+{
+    struct ArchiveEarliest *search = (struct ArchiveEarliest *)context;
+    search->rows[task] = -1;
+    if (partition->month > atomic_load(&search->best_month))
+    {
+        return;
+    }
+    if (!openArchivePartition(partition))
+    {
+        atomic_store(&search->failed, 1);
+        return;
+    }
+
+    const struct LogStore *store = &partition->store;
+    int row = partitionLowerBound(store, packLogKey(search->productID, search->issueCode, 0));
+    if (row < store->size && store->ProductId[row] == search->productID && store->IssueCode[row] == search->issueCode)
+    {
+        search->rows[task] = row;
+        int best = atomic_load(&search->best_month);
+        while (partition->month < best && !atomic_compare_exchange_weak(&search->best_month, &best, partition->month))
+        {
+        }
+    }
+}
+
+
+// Function to find the earliest occurrence ever of an issue code for a product across all months of the archive
+// Sets *partition and *row to the month and row of the match, and *searched to the number of months searched
+// Returns 1 if found, 0 if not, or -1 if a partition could not be opened or memory could not be allocated
+static inline int archiveEarliestOccurrence(struct LogArchive *archive, int productID, int issueCode, int thread_count,
+                                            int *partition, int *row, int *searched)
+{
+    *searched = 0;
+    if (!fitsLogKey(productID, issueCode))
+    {
+        return 0;
+    }
+
+    int *candidates = (int *)malloc((size_t)(archive->count > 0 ? archive->count : 1) * sizeof(int));
+    int *rows = (int *)malloc((size_t)(archive->count > 0 ? archive->count : 1) * sizeof(int));
+    if (candidates == NULL || rows == NULL)
+    {
+        free(candidates);
+        free(rows);
+        printf("Memory allocation failed.\n");
+        return -1;
+    }
+
+    struct ArchiveEarliest search;
+    search.productID = productID;
+    search.issueCode = issueCode;
+    search.rows = rows;
+    atomic_init(&search.best_month, INT_MAX);
+    atomic_init(&search.failed, 0);
+
+    struct ArchiveQuery query;
+    query.archive = archive;
+    query.candidates = candidates;
+    query.candidate_count = selectArchivePartitions(archive, productID, INT_MIN, INT_MAX, candidates);
+    query.run = findEarliestInPartition;
+    query.context = &search;
+    runArchiveQuery(&query, thread_count);
+
+    // The candidates are in month order, so the first match is the earliest
+    int found = atomic_load(&search.failed) ? -1 : 0;
+    for (int t = 0; t < query.candidate_count && found == 0; t++)
+    {
+        if (rows[t] != -1)
+        {
+            *partition = candidates[t];
+            *row = rows[t];
+            found = 1;
+        }
+    }
+    *searched = query.candidate_count;
+
+    free(candidates);
+    free(rows);
+    return found;
+}
+
+
+// Archive query task: count the logs of the product in one partition from its first and last row
+static inline void countInPartition(void *context, struct ArchivePartition *partition, int task)
+{
+    struct ArchiveCount *count = (struct ArchiveCount *)context;
+    count->counts[task] = 0;
+    if (!openArchivePartition(partition))
+    {
+        atomic_store(&count->failed, 1);
+        return;
+    }
+
+    const struct LogStore *store = &partition->store;
+    int first = partitionLowerBound(store, packLogKey(count->productID, 0, 0));
+    int end = count->productID + 1 < LOG_KEY_FIELD_LIMIT ? partitionLowerBound(store, packLogKey(count->productID + 1, 0, 0)) : store->size;
+    count->counts[task] = end - first;
+}
+
+
+// Function to count the issues of a product in months first_month to last_month (INT_MIN and INT_MAX for no bound)
+// month_counts[p] receives the count of partition p, 0 for pruned partitions; *searched the number of months searched
+// Returns the total, or -1 if a partition could not be opened or memory could not be allocated
+static inline long long archiveCountIssues(struct LogArchive *archive, int productID, int first_month, int last_month,
+                                           int thread_count, int month_counts[], int *searched)
+{
+    *searched = 0;
+    memset(month_counts, 0, (size_t)archive->count * sizeof(int));
+    if (!fitsLogKey(productID, 0))
+    {
+        return 0;
+    }
+
+    int *candidates = (int *)malloc((size_t)(archive->count > 0 ? archive->count : 1) * sizeof(int));
+    int *counts = (int *)malloc((size_t)(archive->count > 0 ? archive->count : 1) * sizeof(int));
+    if (candidates == NULL || counts == NULL)
+    {
+        free(candidates);
+        free(counts);
+        printf("Memory allocation failed.\n");
+        return -1;
+    }
+
+    struct ArchiveCount count;
+    count.productID = productID;
+    count.counts = counts;
+    atomic_init(&count.failed, 0);
+
+    struct ArchiveQuery query;
+    query.archive = archive;
+    query.candidates = candidates;
+    query.candidate_count = selectArchivePartitions(archive, productID, first_month, last_month, candidates);
+    query.run = countInPartition;
+    query.context = &count;
+    runArchiveQuery(&query, thread_count);
+
+    long long total = 0;
+    for (int t = 0; t < query.candidate_count; t++)
+    {
+        month_counts[candidates[t]] = counts[t];
+        total += counts[t];
+    }
+    *searched = query.candidate_count;
+    total = atomic_load(&count.failed) ? -1 : total;
+
+    free(candidates);
+    free(counts);
+    return total;
+}
+
+#endif
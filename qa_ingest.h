@@ -0,0 +1,205 @@
+/*
+Concurrent ingestion of the logs of several production lines.
+
+In production every line logs at the same time. Each line gets its own single-producer/single-consumer ring of
+logs, written by that line's thread and read by one consumer thread, which appends the logs to the log store in
+batches and brings a report up to date with each one (a LogAppendFunction, as for appendCsvLogs).
+
+A ring needs no lock: only the producer moves its tail and only the consumer moves its head, each with one atomic
+store per log pushed or per batch taken, and each side keeps a copy of the other's index which it rereads only when
+the ring looks full or empty, so the two threads share a cache line only when they must. The indexes sit on cache
+lines of their own.
+
+A producer finding its ring full waits for the consumer to make room rather than dropping the log, so a burst
+longer than the ring slows the line down but loses nothing. The consumer stops once every producer has said it is
+done and every ring is empty.
+Build with -pthread.
+*/
+
+#ifndef QA_INGEST_H
+#define QA_INGEST_H
+
+#include "qa_log_store.h"
+#include "qa_log_csv.h"
+
+#include <stdatomic.h>
+
+#ifndef _WIN32
+#include <sched.h>
+#endif
+
+#define INGEST_MAX_LINES 16
+#define INGEST_RING_CAPACITY 4096 // Logs per ring, a power of two
+#define INGEST_BATCH 256          // Most logs the consumer takes from a ring at once
+#define INGEST_CACHE_LINE 64
+
+// Define a single-producer/single-consumer ring of logs
+struct LogRing
+{
+    _Alignas(INGEST_CACHE_LINE) atomic_size_t tail; // Next slot to write, moved by the producer
+    size_t cached_head;                             // Producer's copy of head
+    uint64_t full_waits;                            // Pushes that found the ring full
+    _Alignas(INGEST_CACHE_LINE) atomic_size_t head; // Next slot to read, moved by the consumer
+    size_t cached_tail;                             // Consumer's copy of tail
+    _Alignas(INGEST_CACHE_LINE) struct ProductionLine_Log *slots;
+    size_t mask;
+};
+
+// Define the rings of all lines, how many producers are done and whether the consumer has given up
+struct LogIngest
+{
+    struct LogRing rings[INGEST_MAX_LINES];
+    int line_count;
+    atomic_int producers_done;
+    atomic_int consumer_failed;
+};
+
+
+// Function to let other threads run while waiting on a ring
+static inline void ingestYield(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+
+// Function to release the rings of an ingestion front end
+static inline void freeLogIngest(struct LogIngest *ingest)
+{
+    for (int l = 0; l < ingest->line_count; l++)
+    {
+        free(ingest->rings[l].slots);
+    }
+    ingest->line_count = 0;
+}
+
+
+// Function to create empty rings for line_count production lines
+// Returns 0 if memory could not be allocated
+static inline int initLogIngest(struct LogIngest *ingest, int line_count)
+{
+    memset(ingest, 0, sizeof(struct LogIngest));
+    for (int l = 0; l < line_count; l++)
+    {
+        struct LogRing *ring = &ingest->rings[l];
+        ring->slots = (struct ProductionLine_Log *)malloc(INGEST_RING_CAPACITY * sizeof(struct ProductionLine_Log));
+        ring->mask = INGEST_RING_CAPACITY - 1;
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        ingest->line_count++;
+        if (ring->slots == NULL)
+        {
+            freeLogIngest(ingest);
+            printf("Memory allocation failed.\n");
+            return 0;
+        }
+    }
+    atomic_init(&ingest->producers_done, 0);
+    atomic_init(&ingest->consumer_failed, 0);
+    return 1;
+}
+
+
+// Function to push a log into the ring of a line from that line's producer thread, waiting while the ring is full
+// Returns 0, without pushing, if the consumer has given up
+static inline int pushLogIngest(struct LogIngest *ingest, int line, const struct ProductionLine_Log *log)
+{
+    struct LogRing *ring = &ingest->rings[line];
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (tail - ring->cached_head == INGEST_RING_CAPACITY)
+    {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head == INGEST_RING_CAPACITY)
+        {
+            ring->full_waits++;
+            do
+            {
+                if (atomic_load_explicit(&ingest->consumer_failed, memory_order_relaxed))
+                {
+                    return 0;
+                }
+                ingestYield();
+                ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            } while (tail - ring->cached_head == INGEST_RING_CAPACITY);
+        }
+    }
+
+    ring->slots[tail & ring->mask] = *log;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+
+// Function for a producer thread to say it has pushed its last log
+static inline void finishLogProducer(struct LogIngest *ingest)
+{
+    atomic_fetch_add_explicit(&ingest->producers_done, 1, memory_order_release);
+}
+
+
+// Function to take up to INGEST_BATCH logs from a ring into the store, updating the report with each one
+// Returns the number of logs taken, or -1 if memory could not be allocated or the report could not be updated
+static inline int takeLogRing(struct LogRing *ring, struct LogStore *store, LogAppendFunction update_report, void *report)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (ring->cached_tail == head)
+    {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (ring->cached_tail == head)
+        {
+            return 0;
+        }
+    }
+
+    size_t available = ring->cached_tail - head;
+    int count = available < INGEST_BATCH ? (int)available : INGEST_BATCH;
+    for (int i = 0; i < count; i++)
+    {
+        if (!appendLog(store, &ring->slots[(head + (size_t)i) & ring->mask]) ||
+            (update_report != NULL && !update_report(report, store, store->size - 1)))
+        {
+            printf("Could not add log %d to the store.\n", store->size);
+            return -1;
+        }
+    }
+
+    // The slots are handed back to the producer only once they have been copied
+    atomic_store_explicit(&ring->head, head + (size_t)count, memory_order_release);
+    return count;
+}
+
+
+// Function to run the consumer: take logs from every ring in turn until all producers are done and all rings empty
+// Returns 0 if a log could not be added to the store or the report, after telling the producers to stop
+static inline int consumeLogIngest(struct LogIngest *ingest, struct LogStore *store, LogAppendFunction update_report, void *report)
+{
+    for (;;)
+    {
+        // Read before the rings are drained, so that no log pushed before the last producer finished can be missed
+        int done = atomic_load_explicit(&ingest->producers_done, memory_order_acquire) == ingest->line_count;
+        int taken = 0;
+        for (int l = 0; l < ingest->line_count; l++)
+        {
+            int count = takeLogRing(&ingest->rings[l], store, update_report, report);
+            if (count < 0)
+            {
+                atomic_store_explicit(&ingest->consumer_failed, 1, memory_order_relaxed);
+                return 0;
+            }
+            taken += count;
+        }
+        if (taken == 0)
+        {
+            if (done)
+            {
+                return 1;
+            }
+            ingestYield();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,501 @@
+/*
+CSV import and export for the shared log store.
+
+The line controllers export one QA log per line, with the seven fields of the task headers spread over 11 columns:
+
+    LineCode,BatchCode,Day,Hour,Minute,ProductId,IssueCode,IssueDescription,ResolutionCode,ResolutionDescription,ReportingEmployeeId
+
+Descriptions may be quoted ("..." with "" for a quote) and then contain commas, but not line breaks. A first line
+that does not start with a number is taken as a header and skipped; blank lines and CRLF line ends are accepted.
+
+The file is streamed in blocks of CSV_BLOCK_SIZE bytes. Each block is cut at its last line break and split at line
+breaks into one piece per thread; the pieces are parsed in parallel into private log stores, which are then appended
+to the result in file order. Fields are parsed in place and descriptions are copied once into the fixed buffers of
+a struct ProductionLine_Log before being interned, so nothing is allocated per field or per log.
+Build with -pthread.
+
+Logs that arrive during the month can also be appended one line at a time with appendCsvLogs(), which hands each
+new row to a report update function instead of rebuilding the report.
+*/
+
+#ifndef QA_LOG_CSV_H
+#define QA_LOG_CSV_H
+
+#include "qa_log_store.h"
+
+#include <pthread.h>
+
+#define CSV_BLOCK_SIZE (64 << 20)
+#define CSV_MIN_PIECE_SIZE (1 << 16)
+#define CSV_WRITE_BUFFER (1 << 20)
+#define CSV_MAX_LINE 4096
+
+// Signature of the function that brings a report up to date with row, just appended to the store
+// Returns 0 if the report could not be updated
+typedef int (*LogAppendFunction)(void *report, const struct LogStore *store, int row);
+
+// Define the part of a block parsed by one thread
+struct CsvPiece
+{
+    const char *begin;
+    const char *end;            // Just after a line break, or the end of the block
+    struct LogStore store;      // Logs of the piece, with their own string pool
+    int64_t lines;              // Lines parsed so far, blank lines included
+    int failed;                 // 1 if the next line is malformed, 2 if memory could not be allocated
+};
+
+
+// Function to parse a decimal integer field
+// Returns the position after the field, or NULL if there is no number or it does not fit an int
+static inline const char *parseCsvInt(const char *p, const char *end, int *value)
+{
+    if (p == NULL)
+    {
+        return NULL;
+    }
+    while (p < end && *p == ' ')
+    {
+        p++;
+    }
+
+    int negative = p < end && *p == '-';
+    p += negative;
+    const char *digits = p;
+    int64_t number = 0;
+    while (p < end && *p >= '0' && *p <= '9' && number <= INT32_MAX)
+    {
+        number = number * 10 + (*p - '0');
+        p++;
+    }
+    if (p == digits || number > INT32_MAX)
+    {
+        return NULL;
+    }
+
+    *value = (int)(negative ? -number : number);
+    return p;
+}
+
+
+// Function to parse a text field, quoted or not, into a buffer of size bytes
+// Returns the position after the field, or NULL if the quotes are not closed or the text does not fit
+static inline const char *parseCsvText(const char *p, const char *end, char text[], size_t size)
+{
+    if (p == NULL)
+    {
+        return NULL;
+    }
+
+    size_t length = 0;
+    if (p < end && *p == '"')
+    {
+        p++;
+        for (;;)
+        {
+            if (p == end)
+            {
+                return NULL;
+            }
+            char c = *p++;
+            if (c == '"')
+            {
+                if (p == end || *p != '"')
+                {
+                    break;
+                }
+                p++;
+            }
+            if (length + 1 == size)
+            {
+                return NULL;
+            }
+            text[length++] = c;
+        }
+    }
+    else
+    {
+        while (p < end && *p != ',')
+        {
+            if (length + 1 == size)
+            {
+                return NULL;
+            }
+            text[length++] = *p++;
+        }
+    }
+
+    text[length] = '\0';
+    return p;
+}
+
+
+// Function to skip the comma between two fields
+// Returns the position of the next field, or NULL if there is no comma
+static inline const char *skipCsvComma(const char *p, const char *end)
+{
+    return p != NULL && p < end && *p == ',' ? p + 1 : NULL;
+}
+
+
+// Function to parse one line, without its line break, into a log
+// Returns 0 if the line is malformed or Batch Date & Time is out of range
+static inline int parseCsvLine(const char *line, const char *end, struct ProductionLine_Log *log)
+{
+    const char *p = parseCsvInt(line, end, &log->LineCode);
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->BatchCode);
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->BatchDateTime.dayofmonth);
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->BatchDateTime.hourofday);
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->BatchDateTime.minuteofhour);
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->ProductId);
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->IssueCode);
+    p = parseCsvText(skipCsvComma(p, end), end, log->IssueDescription, sizeof(log->IssueDescription));
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->ResolutionCode);
+    p = parseCsvText(skipCsvComma(p, end), end, log->ResolutionDescription, sizeof(log->ResolutionDescription));
+    p = parseCsvInt(skipCsvComma(p, end), end, &log->ReportingEmployeeId);
+
+    return p == end && packDateTime(&log->BatchDateTime) >= 0;
+}
+
+
+// Function to parse the lines of a piece into its log store (thread entry point)
+static inline void *parseCsvPiece(void *argument)
+{
+    struct CsvPiece *piece = (struct CsvPiece *)argument;
+    struct ProductionLine_Log log;
+
+    const char *line = piece->begin;
+    while (line < piece->end)
+    {
+        const char *line_end = (const char *)memchr(line, '\n', (size_t)(piece->end - line));
+        const char *next = line_end != NULL ? line_end + 1 : piece->end;
+        line_end = line_end != NULL ? line_end : piece->end;
+        if (line_end > line && line_end[-1] == '\r')
+        {
+            line_end--;
+        }
+
+        if (line_end > line)
+        {
+            if (!parseCsvLine(line, line_end, &log))
+            {
+                piece->failed = 1;
+                return NULL;
+            }
+            if (!appendLog(&piece->store, &log))
+            {
+                piece->failed = 2;
+                return NULL;
+            }
+        }
+        piece->lines++;
+        line = next;
+    }
+    return NULL;
+}
+
+
+// Function to parse a block of whole lines on thread_count threads and append its logs to the store
+// lines holds the number of lines of the file before the block and is advanced past it
+// Returns 0 and prints the reason if a line is malformed or memory could not be allocated
+static inline int parseCsvBlock(struct LogStore *store, const char *block, size_t size, int thread_count, int64_t *lines)
+{
+    size_t piece_count = size / CSV_MIN_PIECE_SIZE;
+    piece_count = piece_count < (size_t)thread_count ? piece_count : (size_t)thread_count;
+    piece_count = piece_count > 0 ? piece_count : 1;
+
+    struct CsvPiece *pieces = (struct CsvPiece *)calloc(piece_count, sizeof(struct CsvPiece));
+    pthread_t *threads = (pthread_t *)malloc(piece_count * sizeof(pthread_t));
+    int *started = (int *)calloc(piece_count, sizeof(int));
+    if (pieces == NULL || threads == NULL || started == NULL)
+    {
+        free(pieces);
+        free(threads);
+        free(started);
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+
+    // Cut the block into pieces of about equal size, each ending just after a line break
+    const char *block_end = block + size;
+    const char *begin = block;
+    for (size_t k = 0; k < piece_count; k++)
+    {
+        const char *end = block_end;
+        if (k + 1 < piece_count)
+        {
+            const char *target = block + size / piece_count * (k + 1);
+            target = target > begin ? target : begin;
+            const char *line_break = (const char *)memchr(target, '\n', (size_t)(block_end - target));
+            end = line_break != NULL ? line_break + 1 : block_end;
+        }
+        initLogStore(&pieces[k].store);
+        pieces[k].begin = begin;
+        pieces[k].end = end;
+        begin = end;
+    }
+
+    // Parse the first piece on this thread and the others on their own threads, or here if a thread cannot start
+    for (size_t k = 1; k < piece_count; k++)
+    {
+        started[k] = pthread_create(&threads[k], NULL, parseCsvPiece, &pieces[k]) == 0;
+    }
+    parseCsvPiece(&pieces[0]);
+    for (size_t k = 1; k < piece_count; k++)
+    {
+        if (started[k])
+        {
+            pthread_join(threads[k], NULL);
+        }
+        else
+        {
+            parseCsvPiece(&pieces[k]);
+        }
+    }
+
+    // Append the pieces in file order
+    int status = 1;
+    for (size_t k = 0; k < piece_count; k++)
+    {
+        if (status && pieces[k].failed == 1)
+        {
+            printf("Line %lld is not a valid QA log.\n", (long long)(*lines + pieces[k].lines + 1));
+            status = 0;
+        }
+        else if (status && (pieces[k].failed == 2 || !appendLogStore(store, &pieces[k].store)))
+        {
+            printf("Memory allocation failed.\n");
+            status = 0;
+        }
+        *lines += pieces[k].lines;
+        freeLogStore(&pieces[k].store);
+    }
+
+    free(pieces);
+    free(threads);
+    free(started);
+    return status;
+}
+
+
+// Function to append the logs of a CSV file to the store, parsing on thread_count threads
+// The ingest throughput is reported on stderr
+// Returns 0 and prints the reason if the file could not be read or holds an invalid line
+static inline int readLogCsv(struct LogStore *store, const char *path, int thread_count)
+{
+    FILE *file = fopen(path, "rb");
+    char *buffer = (char *)malloc(CSV_BLOCK_SIZE);
+    if (file == NULL || buffer == NULL)
+    {
+        printf(file == NULL ? "Could not open CSV file %s.\n" : "Memory allocation failed.\n", path);
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        free(buffer);
+        return 0;
+    }
+
+    double start = currentTimeMs();
+    uint64_t bytes = 0;
+    int64_t lines = 0;
+    int first_block = 1;
+    size_t carried = 0;
+    int status = 1;
+
+    while (status)
+    {
+        size_t read = fread(buffer + carried, 1, CSV_BLOCK_SIZE - carried, file);
+        size_t filled = carried + read;
+        int at_end = read < CSV_BLOCK_SIZE - carried;
+        bytes += read;
+        if (at_end && ferror(file))
+        {
+            printf("Could not read CSV file %s.\n", path);
+            status = 0;
+            break;
+        }
+
+        // Parse up to the last line break; the partial line after it is carried over to the next block
+        size_t usable = filled;
+        if (!at_end)
+        {
+            while (usable > 0 && buffer[usable - 1] != '\n')
+            {
+                usable--;
+            }
+            if (usable == 0)
+            {
+                printf("Line %lld of %s is longer than %d bytes.\n", (long long)lines + 1, path, CSV_BLOCK_SIZE);
+                status = 0;
+                break;
+            }
+        }
+
+        // Skip a UTF-8 byte order mark and a header line at the start of the file
+        const char *begin = buffer;
+        if (first_block)
+        {
+            if (usable >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+            {
+                begin += 3;
+            }
+            if (begin < buffer + usable && (*begin < '0' || *begin > '9') && *begin != '-' && *begin != ' ')
+            {
+                const char *line_break = (const char *)memchr(begin, '\n', (size_t)(buffer + usable - begin));
+                begin = line_break != NULL ? line_break + 1 : buffer + usable;
+                lines++;
+            }
+            first_block = 0;
+        }
+
+        status = parseCsvBlock(store, begin, (size_t)(buffer + usable - begin), thread_count, &lines);
+
+        carried = filled - usable;
+        memmove(buffer, buffer + usable, carried);
+        if (at_end)
+        {
+            break;
+        }
+    }
+
+    double elapsed_ms = currentTimeMs() - start;
+    if (status)
+    {
+        double megabytes = bytes / (1024.0 * 1024.0);
+        fprintf(stderr, "Imported %d logs (%.1f MB) from %s in %.3f ms: %.1f MB/s on %d threads\n",
+                store->size, megabytes, path, elapsed_ms, elapsed_ms > 0 ? megabytes * 1000.0 / elapsed_ms : 0.0, thread_count);
+    }
+
+    fclose(file);
+    free(buffer);
+    return status;
+}
+
+
+// Function to read the next log of a CSV stream one line at a time, for logs arriving while reports are kept up to date
+// line_number counts the lines read so far; a header line at the start of the stream is skipped
+// Returns 1 if a log was read, 0 at the end of the stream, or -1 and prints the reason if a line is malformed
+static inline int readCsvLog(FILE *file, struct ProductionLine_Log *log, int64_t *line_number)
+{
+    char line[CSV_MAX_LINE];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        (*line_number)++;
+        size_t length = strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n')
+        {
+            printf("Line %lld is longer than %d bytes.\n", (long long)*line_number, CSV_MAX_LINE - 2);
+            return -1;
+        }
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        {
+            length--;
+        }
+
+        if (length == 0 || (*line_number == 1 && (line[0] < '0' || line[0] > '9') && line[0] != '-' && line[0] != ' '))
+        {
+            continue;
+        }
+        if (!parseCsvLine(line, line + length, log))
+        {
+            printf("Line %lld is not a valid QA log.\n", (long long)*line_number);
+            return -1;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+// Function to append the logs of a CSV file ("-" for standard input) to the store one by one as they are read,
+// calling update_report after each so that a report never needs to be rebuilt
+// The time per appended log is reported on stderr
+// Returns 0 and prints the reason if the file could not be read or a log could not be added
+static inline int appendCsvLogs(struct LogStore *store, const char *path, LogAppendFunction update_report, void *report)
+{
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Could not open CSV file %s.\n", path);
+        return 0;
+    }
+
+    struct ProductionLine_Log log;
+    int64_t line_number = 0;
+    int appended = 0;
+    int status;
+    double start = currentTimeMs();
+
+    while ((status = readCsvLog(file, &log, &line_number)) == 1)
+    {
+        if (!appendLog(store, &log) || !update_report(report, store, store->size - 1))
+        {
+            printf("The log on line %lld could not be added.\n", (long long)line_number);
+            status = -1;
+            break;
+        }
+        appended++;
+    }
+
+    double elapsed_ms = currentTimeMs() - start;
+    fprintf(stderr, "Appended %d logs from %s in %.3f ms (%.3f us per log)\n",
+            appended, path, elapsed_ms, appended > 0 ? elapsed_ms * 1000.0 / appended : 0.0);
+
+    if (file != stdin)
+    {
+        fclose(file);
+    }
+    return status == 0;
+}
+
+
+// Function to write a description as a quoted CSV field
+static inline void writeCsvText(FILE *file, const char *text)
+{
+    fputc('"', file);
+    for (; *text != '\0'; text++)
+    {
+        if (*text == '"')
+        {
+            fputc('"', file);
+        }
+        fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+
+// Function to write the logs of the store to a CSV file with a header line
+// Returns 0 and prints the reason if the file could not be written
+static inline int writeLogCsv(const struct LogStore *store, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        printf("Could not create CSV file %s.\n", path);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, CSV_WRITE_BUFFER);
+
+    fprintf(file, "LineCode,BatchCode,Day,Hour,Minute,ProductId,IssueCode,IssueDescription,ResolutionCode,ResolutionDescription,ReportingEmployeeId\n");
+    for (int i = 0; i < store->size; i++)
+    {
+        struct DateTime date_time = unpackDateTime(store->BatchDateTime[i]);
+        fprintf(file, "%d,%d,%d,%d,%d,%d,%d,", store->LineCode[i], store->BatchCode[i], date_time.dayofmonth,
+                date_time.hourofday, date_time.minuteofhour, store->ProductId[i], store->IssueCode[i]);
+        writeCsvText(file, poolString(&store->strings, store->IssueDescription[i]));
+        fprintf(file, ",%d,", store->ResolutionCode[i]);
+        writeCsvText(file, poolString(&store->strings, store->ResolutionDescription[i]));
+        fprintf(file, ",%d\n", store->ReportingEmployeeId[i]);
+    }
+
+    int written = !ferror(file);
+    if (fclose(file) != 0 || !written)
+    {
+        printf("Could not write CSV file %s.\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,422 @@
+/*
+Binary monthly QA log file for the shared log store.
+
+A .qalog file is the log store written column by column, so that a month of logs can be opened by mapping the
+file into memory instead of parsing and copying it:
+
+    struct LogFileHeader
+    struct LogFileColumn directory[column_count]
+    column data, each column starting on a LOG_FILE_ALIGNMENT boundary
+
+The columns are the nine log fields of struct LogStore followed by the string offsets and the string text of its
+string pool. Values are stored in the byte order of the machine that wrote the file; a file written with the
+other byte order is rejected by its byte order mark.
+
+Opening a file checks the header, the directory, the string offsets and the two description columns, whose string
+ids must name strings of the pool; the other log columns are read from the page cache on first use. The header also
+holds a fingerprint of the Product ID, Issue Code and Batch Date & Time columns, so that files built from a log file,
+such as its index, can tell in O(1) whether they are opened with the logs they were built from. The file is mapped
+copy-on-write: sorting a mapped store reorders its private pages and never writes back to the file.
+*/
+
+#ifndef QA_LOG_FILE_H
+#define QA_LOG_FILE_H
+
+#include "qa_log_store.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The magic ends in the version, so that the two change together
+#define LOG_FILE_MAGIC "QALOGV2"
+#define LOG_FILE_VERSION 2
+#define LOG_FILE_BYTE_ORDER_MARK 0x01020304u
+#define LOG_FILE_ALIGNMENT 64
+#define LOG_FILE_WRITE_BUFFER (1 << 20)
+
+// Define the column ids of a log file, in file order
+enum LogFileColumnId
+{
+    LOG_COLUMN_LINE_CODE,
+    LOG_COLUMN_BATCH_CODE,
+    LOG_COLUMN_BATCH_DATE_TIME,
+    LOG_COLUMN_PRODUCT_ID,
+    LOG_COLUMN_ISSUE_CODE,
+    LOG_COLUMN_ISSUE_DESCRIPTION,
+    LOG_COLUMN_RESOLUTION_CODE,
+    LOG_COLUMN_RESOLUTION_DESCRIPTION,
+    LOG_COLUMN_REPORTING_EMPLOYEE_ID,
+    LOG_COLUMN_STRING_OFFSETS,
+    LOG_COLUMN_STRING_TEXT,
+    LOG_FILE_COLUMN_COUNT
+};
+
+// Define the header at the start of a log file
+struct LogFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t column_count;
+    uint32_t reserved;
+    uint64_t log_count;
+    uint64_t string_count;
+    uint64_t file_size;
+    uint64_t fingerprint; // Hash of the Product ID, Issue Code and Batch Date & Time columns
+};
+
+// Define an entry of the column directory that follows the header
+struct LogFileColumn
+{
+    uint32_t column_id;
+    uint32_t element_size;
+    uint64_t offset;        // From the start of the file
+    uint64_t size;          // In bytes
+};
+
+
+// Function to list the columns of a store in file order, with their element sizes and element counts
+static inline void describeLogColumns(const struct LogStore *store, const void *columns[], uint32_t element_sizes[], uint64_t counts[])
+{
+    const void *log_columns[] = {store->LineCode, store->BatchCode, store->BatchDateTime, store->ProductId, store->IssueCode,
+                                 store->IssueDescription, store->ResolutionCode, store->ResolutionDescription, store->ReportingEmployeeId};
+    for (int id = 0; id < LOG_COLUMN_STRING_OFFSETS; id++)
+    {
+        columns[id] = log_columns[id];
+        element_sizes[id] = id == LOG_COLUMN_BATCH_DATE_TIME ? sizeof(uint16_t) : sizeof(int32_t);
+        counts[id] = (uint64_t)store->size;
+    }
+
+    columns[LOG_COLUMN_STRING_OFFSETS] = store->strings.offsets;
+    element_sizes[LOG_COLUMN_STRING_OFFSETS] = sizeof(uint32_t);
+    counts[LOG_COLUMN_STRING_OFFSETS] = (uint64_t)store->strings.count;
+
+    columns[LOG_COLUMN_STRING_TEXT] = store->strings.text;
+    element_sizes[LOG_COLUMN_STRING_TEXT] = 1;
+    counts[LOG_COLUMN_STRING_TEXT] = store->strings.text_size;
+}
+
+
+// Function to hash the Product ID, Issue Code and Batch Date & Time columns of the store (FNV-1a over 32-bit values)
+// Months with the same number of logs and descriptions still differ in these columns, so the hash tells them apart
+static inline uint64_t fingerprintLogColumns(const struct LogStore *store)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < store->size; i++)
+    {
+        hash = (hash ^ (uint32_t)store->ProductId[i]) * 1099511628211ull;
+        hash = (hash ^ (uint32_t)store->IssueCode[i]) * 1099511628211ull;
+        hash = (hash ^ store->BatchDateTime[i]) * 1099511628211ull;
+    }
+    return (hash ^ (uint64_t)store->size) * 1099511628211ull;
+}
+
+
+// Function to round a file offset up to the column alignment
+static inline uint64_t alignLogFileOffset(uint64_t offset)
+{
+    return (offset + LOG_FILE_ALIGNMENT - 1) & ~(uint64_t)(LOG_FILE_ALIGNMENT - 1);
+}
+
+
+// Function to write the logs of the store to a log file
+// Returns 0 and prints the reason if the file could not be written
+static inline int writeLogFile(const struct LogStore *store, const char *path)
+{
+    const void *columns[LOG_FILE_COLUMN_COUNT];
+    uint32_t element_sizes[LOG_FILE_COLUMN_COUNT];
+    uint64_t counts[LOG_FILE_COLUMN_COUNT];
+    describeLogColumns(store, columns, element_sizes, counts);
+
+    struct LogFileHeader header;
+    struct LogFileColumn directory[LOG_FILE_COLUMN_COUNT];
+    memset(&header, 0, sizeof(header));
+    memset(directory, 0, sizeof(directory));
+
+    uint64_t offset = sizeof(header) + sizeof(directory);
+    for (int id = 0; id < LOG_FILE_COLUMN_COUNT; id++)
+    {
+        offset = alignLogFileOffset(offset);
+        directory[id].column_id = (uint32_t)id;
+        directory[id].element_size = element_sizes[id];
+        directory[id].offset = offset;
+        directory[id].size = counts[id] * element_sizes[id];
+        offset += directory[id].size;
+    }
+
+    memcpy(header.magic, LOG_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOG_FILE_VERSION;
+    header.byte_order_mark = LOG_FILE_BYTE_ORDER_MARK;
+    header.column_count = LOG_FILE_COLUMN_COUNT;
+    header.log_count = (uint64_t)store->size;
+    header.string_count = (uint64_t)store->strings.count;
+    header.file_size = offset;
+    header.fingerprint = fingerprintLogColumns(store);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        printf("Could not create log file %s.\n", path);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, LOG_FILE_WRITE_BUFFER);
+
+    static const char padding[LOG_FILE_ALIGNMENT] = {0};
+    int written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(directory, sizeof(directory), 1, file) == 1;
+    uint64_t position = sizeof(header) + sizeof(directory);
+    for (int id = 0; id < LOG_FILE_COLUMN_COUNT && written; id++)
+    {
+        size_t gap = (size_t)(directory[id].offset - position);
+        written = (gap == 0 || fwrite(padding, 1, gap, file) == gap) &&
+                  (directory[id].size == 0 || fwrite(columns[id], 1, (size_t)directory[id].size, file) == directory[id].size);
+        position = directory[id].offset + directory[id].size;
+    }
+
+    if (fclose(file) != 0 || !written)
+    {
+        printf("Could not write log file %s.\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+
+// Function to release a file mapping created by mapLogFile
+static inline void releaseLogFileMapping(void *mapping, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, size);
+#endif
+}
+
+
+// Function to map a whole file into memory, copy-on-write
+// Returns the mapping, or NULL if the file could not be opened or mapped
+static inline void *mapWholeFile(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+    LARGE_INTEGER file_size;
+    void *mapping = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && (uint64_t)file_size.QuadPart <= SIZE_MAX)
+    {
+        HANDLE section = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (section != NULL)
+        {
+            mapping = MapViewOfFile(section, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(section);
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return mapping;
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+    {
+        return NULL;
+    }
+    struct stat file_status;
+    void *mapping = NULL;
+    if (fstat(file, &file_status) == 0 && file_status.st_size > 0 && (uint64_t)file_status.st_size <= SIZE_MAX)
+    {
+        *size = (size_t)file_status.st_size;
+        mapping = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = NULL;
+        }
+    }
+    close(file);
+    return mapping;
+#endif
+}
+
+
+// Function to check the header and column directory of a mapped log file
+// Returns the directory, or NULL if the file is not a valid log file
+static inline const struct LogFileColumn *checkLogFile(const unsigned char *mapping, size_t size)
+{
+    if (size < sizeof(struct LogFileHeader) + LOG_FILE_COLUMN_COUNT * sizeof(struct LogFileColumn))
+    {
+        return NULL;
+    }
+
+    const struct LogFileHeader *header = (const struct LogFileHeader *)mapping;
+    if (memcmp(header->magic, LOG_FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != LOG_FILE_VERSION ||
+        header->byte_order_mark != LOG_FILE_BYTE_ORDER_MARK || header->column_count != LOG_FILE_COLUMN_COUNT ||
+        header->file_size != size || header->log_count > INT32_MAX || header->string_count > INT32_MAX)
+    {
+        return NULL;
+    }
+
+    const struct LogFileColumn *directory = (const struct LogFileColumn *)(mapping + sizeof(struct LogFileHeader));
+    for (uint32_t id = 0; id < LOG_FILE_COLUMN_COUNT; id++)
+    {
+        const struct LogFileColumn *column = &directory[id];
+        uint64_t count = id == LOG_COLUMN_STRING_OFFSETS ? header->string_count : header->log_count;
+        uint32_t element_size = id == LOG_COLUMN_BATCH_DATE_TIME ? sizeof(uint16_t) :
+                                id == LOG_COLUMN_STRING_TEXT ? 1 : sizeof(int32_t);
+        if (column->column_id != id || column->element_size != element_size ||
+            column->offset % LOG_FILE_ALIGNMENT != 0 || column->offset > size || column->size > size - column->offset ||
+            (id != LOG_COLUMN_STRING_TEXT && column->size != count * element_size) ||
+            (id == LOG_COLUMN_STRING_TEXT && column->size > UINT32_MAX))
+        {
+            return NULL;
+        }
+    }
+    return directory;
+}
+
+
+// Function to open a log file as a mapped store
+// The string offsets and the Issue and Resolution Description ids are checked so that every description of the file
+// resolves to a terminated string; the other log columns are not read
+// Returns 0 and prints the reason if the file could not be opened, in which case the store is unchanged
+static inline int mapLogFile(struct LogStore *store, const char *path)
+{
+    size_t size = 0;
+    unsigned char *mapping = (unsigned char *)mapWholeFile(path, &size);
+    if (mapping == NULL)
+    {
+        printf("Could not open log file %s.\n", path);
+        return 0;
+    }
+
+    const struct LogFileColumn *directory = checkLogFile(mapping, size);
+    const struct LogFileHeader *header = (const struct LogFileHeader *)mapping;
+    int valid = directory != NULL;
+    if (valid)
+    {
+        const uint32_t *offsets = (const uint32_t *)(mapping + directory[LOG_COLUMN_STRING_OFFSETS].offset);
+        const char *text = (const char *)(mapping + directory[LOG_COLUMN_STRING_TEXT].offset);
+        uint64_t text_size = directory[LOG_COLUMN_STRING_TEXT].size;
+        valid = text_size == 0 || text[text_size - 1] == '\0';
+        for (uint64_t id = 0; id < header->string_count && valid; id++)
+        {
+            valid = offsets[id] < text_size;
+        }
+
+        // Description ids index the string offsets, so an id outside the pool would read outside the file
+        const int32_t *issue_descriptions = (const int32_t *)(mapping + directory[LOG_COLUMN_ISSUE_DESCRIPTION].offset);
+        const int32_t *resolution_descriptions =
+            (const int32_t *)(mapping + directory[LOG_COLUMN_RESOLUTION_DESCRIPTION].offset);
+        for (uint64_t row = 0; row < header->log_count && valid; row++)
+        {
+            valid = issue_descriptions[row] >= 0 && (uint64_t)issue_descriptions[row] < header->string_count &&
+                    resolution_descriptions[row] >= 0 && (uint64_t)resolution_descriptions[row] < header->string_count;
+        }
+    }
+    if (!valid)
+    {
+        releaseLogFileMapping(mapping, size);
+        printf("%s is not a valid log file.\n", path);
+        return 0;
+    }
+
+    freeLogStore(store);
+    store->LineCode = (int32_t *)(mapping + directory[LOG_COLUMN_LINE_CODE].offset);
+    store->BatchCode = (int32_t *)(mapping + directory[LOG_COLUMN_BATCH_CODE].offset);
+    store->BatchDateTime = (uint16_t *)(mapping + directory[LOG_COLUMN_BATCH_DATE_TIME].offset);
+    store->ProductId = (int32_t *)(mapping + directory[LOG_COLUMN_PRODUCT_ID].offset);
+    store->IssueCode = (int32_t *)(mapping + directory[LOG_COLUMN_ISSUE_CODE].offset);
+    store->IssueDescription = (int32_t *)(mapping + directory[LOG_COLUMN_ISSUE_DESCRIPTION].offset);
+    store->ResolutionCode = (int32_t *)(mapping + directory[LOG_COLUMN_RESOLUTION_CODE].offset);
+    store->ResolutionDescription = (int32_t *)(mapping + directory[LOG_COLUMN_RESOLUTION_DESCRIPTION].offset);
+    store->ReportingEmployeeId = (int32_t *)(mapping + directory[LOG_COLUMN_REPORTING_EMPLOYEE_ID].offset);
+    store->size = (int)header->log_count;
+    store->capacity = store->size;   // Any append moves the store onto the heap first
+
+    store->strings.offsets = (uint32_t *)(mapping + directory[LOG_COLUMN_STRING_OFFSETS].offset);
+    store->strings.text = (char *)(mapping + directory[LOG_COLUMN_STRING_TEXT].offset);
+    store->strings.count = (int)header->string_count;
+    store->strings.capacity = store->strings.count;
+    store->strings.text_size = (uint32_t)directory[LOG_COLUMN_STRING_TEXT].size;
+    store->strings.text_capacity = store->strings.text_size;
+
+    store->mapping = mapping;
+    store->mapping_size = size;
+    store->release_mapping = releaseLogFileMapping;
+    return 1;
+}
+
+
+// Function to find the fingerprint of the logs of the store: read from its log file header in O(1) when the store is
+// mapped from a log file (the logs as written to the file), computed from its columns otherwise
+static inline uint64_t logStoreFingerprint(const struct LogStore *store)
+{
+    if (store->mapping != NULL && store->release_mapping == releaseLogFileMapping)
+    {
+        return ((const struct LogFileHeader *)store->mapping)->fingerprint;
+    }
+    return fingerprintLogColumns(store);
+}
+
+
+// Function to check whether a path names a log file by its .qalog extension
+static inline int isLogFilePath(const char *path)
+{
+    size_t length = strlen(path);
+    return length > 6 && strcmp(path + length - 6, ".qalog") == 0;
+}
+
+
+// Function to remove a "--logs path" option from the arguments of a task program
+// Returns the path, or NULL if the option is not given
+static inline const char *takeLogsOption(int *argc, char *argv[])
+{
+    for (int i = 1; i + 1 < *argc; i++)
+    {
+        if (strcmp(argv[i], "--logs") == 0)
+        {
+            const char *path = argv[i + 1];
+            for (int j = i; j + 2 <= *argc; j++)
+            {
+                argv[j] = argv[j + 2];
+            }
+            *argc -= 2;
+            return path;
+        }
+    }
+    return NULL;
+}
+
+
+// Function to load the logs of a task program: the given log file, or the example logs when path is NULL
+// Reports the load time on stderr
+static inline int loadTaskLogs(struct LogStore *store, const char *path)
+{
+    if (path == NULL)
+    {
+        return loadExampleLogs(store);
+    }
+    if (!isLogFilePath(path))
+    {
+        printf("Unsupported log file %s: expected a .qalog file.\n", path);
+        return 0;
+    }
+
+    double start = currentTimeMs();
+    if (!mapLogFile(store, path))
+    {
+        return 0;
+    }
+    fprintf(stderr, "Mapped %d logs from %s in %.3f ms\n", store->size, path, currentTimeMs() - start);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,437 @@
+/*
+Persistent B+-tree index of a binary monthly log file.
+
+Searching or counting through an index built at startup makes every run, even for a single query, pay O(N log(N))
+for the month. A .qaidx file is that index built once, next to its .qalog file, as fixed-size pages which are mapped
+and read in place:
+
+    page 0            - struct LogIndexHeader
+    pages 1 to L      - leaves: (packed log key, row) entries in ascending order, every leaf full but the last
+    pages L + 1 to R  - internal nodes, level by level, the root last
+
+The keys are the packed (Product ID, Issue Code, Batch Date & Time) keys of qa_sort_key.h, ties in row order. Each
+internal node holds, for every child, its first key, its page and the number of entries in the children before it,
+so descending from the root gives the rank of a key (the number of entries below it) and, since the leaves are full,
+the leaf and slot of the entry at that rank. The earliest occurrence of an issue code for a product is the entry at
+the rank of its smallest key, and the issue count of a product the difference of two ranks; each takes one page per
+level, three or four pages for tens of millions of logs.
+
+Opening an index only checks its header against the log file it was built from (its number of logs, size and
+fingerprint), so it takes the same time for any number of logs; page and row numbers are checked as the pages are
+read, and the log a search returns is checked against the key the index holds for it.
+*/
+
+#ifndef QA_LOG_INDEX_H
+#define QA_LOG_INDEX_H
+
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_sort_key.h"
+
+// As for LOG_FILE_MAGIC, the last character of the magic is the version
+#define LOG_INDEX_MAGIC "QAIDXV2"
+#define LOG_INDEX_VERSION 2
+#define LOG_INDEX_PAGE_SIZE 4096
+#define LOG_INDEX_LEAF_ENTRIES 340
+#define LOG_INDEX_NODE_ENTRIES 255
+#define LOG_INDEX_MAX_HEIGHT 16
+
+// Define the header in the first page of an index file
+struct LogIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t page_size;
+    uint32_t height;          // Levels of pages, 1 when the root is a leaf, 0 for an empty index
+    uint64_t entry_count;
+    uint64_t page_count;
+    uint64_t root_page;
+    uint64_t log_count;       // Logs of the log file the index was built from
+    uint64_t log_file_size;   // Size of that log file
+    uint64_t log_fingerprint; // Fingerprint of its logs, from its header (see fingerprintLogColumns)
+};
+
+// Define a leaf page: entries in ascending key order
+struct LogIndexLeaf
+{
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t keys[LOG_INDEX_LEAF_ENTRIES];
+    int32_t rows[LOG_INDEX_LEAF_ENTRIES];
+};
+
+// Define an internal page: its children in ascending key order
+struct LogIndexNode
+{
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t keys[LOG_INDEX_NODE_ENTRIES];      // First key under each child
+    uint32_t children[LOG_INDEX_NODE_ENTRIES];  // Page of each child
+    uint32_t preceding[LOG_INDEX_NODE_ENTRIES]; // Entries under the children before each child
+};
+
+_Static_assert(sizeof(struct LogIndexHeader) <= LOG_INDEX_PAGE_SIZE, "index header must fit a page");
+_Static_assert(sizeof(struct LogIndexLeaf) <= LOG_INDEX_PAGE_SIZE, "index leaf must fit a page");
+_Static_assert(sizeof(struct LogIndexNode) <= LOG_INDEX_PAGE_SIZE, "index node must fit a page");
+
+// Define a mapped index file
+struct LogIndex
+{
+    const unsigned char *mapping;
+    size_t size;
+    const struct LogIndexHeader *header;
+};
+
+// Define a child of the index level being written: its first key, page and number of entries under it
+struct LogIndexChild
+{
+    uint64_t key;
+    uint32_t page;
+    uint32_t count;
+};
+
+
+// Function to write one zero-padded page to an index file
+static inline int writeLogIndexPage(FILE *file, const void *page, size_t size)
+{
+    static const char padding[LOG_INDEX_PAGE_SIZE] = {0};
+    return fwrite(page, size, 1, file) == 1 &&
+           (size == LOG_INDEX_PAGE_SIZE || fwrite(padding, LOG_INDEX_PAGE_SIZE - size, 1, file) == 1);
+}
+
+
+// Function to write a B+-tree index of the store to an index file in O(N)
+// The store should be mapped from the log file the index is for, whose size is recorded in the index
+// Returns 0 and prints the reason if a log does not fit into a packed key or the file could not be written
+static inline int writeLogIndex(const struct LogStore *store, const char *path)
+{
+    int size = store->size;
+    int leaf_count = (size + LOG_INDEX_LEAF_ENTRIES - 1) / LOG_INDEX_LEAF_ENTRIES;
+    struct LogIndexChild *children = (struct LogIndexChild *)malloc((size_t)(leaf_count > 0 ? leaf_count : 1) * sizeof(struct LogIndexChild));
+    if (children == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+    struct SortEntry *entries = sortLogKeyEntries(store, "indexed");
+    if (entries == NULL)
+    {
+        free(children);
+        return 0;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        printf("Could not create index file %s.\n", path);
+        free(entries);
+        free(children);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, LOG_FILE_WRITE_BUFFER);
+
+    // The header is written last, once the root is known
+    struct LogIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    int written = writeLogIndexPage(file, &header, sizeof(header));
+    uint32_t page = 1;
+
+    // Leaves, every one full but the last
+    struct LogIndexLeaf leaf;
+    for (int l = 0; l < leaf_count && written; l++)
+    {
+        int first = l * LOG_INDEX_LEAF_ENTRIES;
+        int count = size - first < LOG_INDEX_LEAF_ENTRIES ? size - first : LOG_INDEX_LEAF_ENTRIES;
+        memset(&leaf, 0, sizeof(leaf));
+        leaf.count = (uint32_t)count;
+        for (int e = 0; e < count; e++)
+        {
+            leaf.keys[e] = entries[first + e].key;
+            leaf.rows[e] = entries[first + e].index;
+        }
+        children[l].key = leaf.keys[0];
+        children[l].page = page++;
+        children[l].count = (uint32_t)count;
+        written = writeLogIndexPage(file, &leaf, sizeof(leaf));
+    }
+
+    // Internal levels, each one the children of the next, until a single root is left
+    int level_count = leaf_count;
+    uint32_t height = leaf_count > 0 ? 1 : 0;
+    struct LogIndexNode node;
+    while (level_count > 1 && written)
+    {
+        int node_count = 0;
+        for (int first = 0; first < level_count && written; first += LOG_INDEX_NODE_ENTRIES)
+        {
+            int count = level_count - first < LOG_INDEX_NODE_ENTRIES ? level_count - first : LOG_INDEX_NODE_ENTRIES;
+            uint32_t preceding = 0;
+            memset(&node, 0, sizeof(node));
+            node.count = (uint32_t)count;
+            for (int c = 0; c < count; c++)
+            {
+                node.keys[c] = children[first + c].key;
+                node.children[c] = children[first + c].page;
+                node.preceding[c] = preceding;
+                preceding += children[first + c].count;
+            }
+
+            // The parents replace their children in place: node_count never passes first
+            children[node_count].key = node.keys[0];
+            children[node_count].page = page++;
+            children[node_count].count = preceding;
+            node_count++;
+            written = writeLogIndexPage(file, &node, sizeof(node));
+        }
+        level_count = node_count;
+        height++;
+    }
+
+    memcpy(header.magic, LOG_INDEX_MAGIC, sizeof(header.magic));
+    header.version = LOG_INDEX_VERSION;
+    header.byte_order_mark = LOG_FILE_BYTE_ORDER_MARK;
+    header.page_size = LOG_INDEX_PAGE_SIZE;
+    header.height = height;
+    header.entry_count = (uint64_t)size;
+    header.page_count = page;
+    header.root_page = leaf_count > 0 ? children[0].page : 0;
+    header.log_count = (uint64_t)size;
+    header.log_file_size = store->mapping_size;
+    header.log_fingerprint = logStoreFingerprint(store);
+    written = written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+
+    free(entries);
+    free(children);
+    if (fclose(file) != 0 || !written)
+    {
+        printf("Could not write index file %s.\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+
+// Function to release a mapped index file
+static inline void closeLogIndex(struct LogIndex *index)
+{
+    if (index->mapping != NULL)
+    {
+        releaseLogFileMapping((void *)index->mapping, index->size);
+    }
+    memset(index, 0, sizeof(struct LogIndex));
+}
+
+
+// Function to map an index file built from the logs of the store, checking only its header, in O(1)
+// Returns 0 and prints the reason if the file could not be opened, is not an index file or is for other logs
+static inline int openLogIndex(struct LogIndex *index, const char *path, const struct LogStore *store)
+{
+    memset(index, 0, sizeof(struct LogIndex));
+    size_t size = 0;
+    unsigned char *mapping = (unsigned char *)mapWholeFile(path, &size);
+    if (mapping == NULL)
+    {
+        printf("Could not open index file %s.\n", path);
+        return 0;
+    }
+
+    const struct LogIndexHeader *header = (const struct LogIndexHeader *)mapping;
+    if (size < LOG_INDEX_PAGE_SIZE || memcmp(header->magic, LOG_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != LOG_INDEX_VERSION || header->byte_order_mark != LOG_FILE_BYTE_ORDER_MARK ||
+        header->page_size != LOG_INDEX_PAGE_SIZE || header->page_count * LOG_INDEX_PAGE_SIZE != size ||
+        header->height > LOG_INDEX_MAX_HEIGHT || header->entry_count != header->log_count ||
+        (header->entry_count > 0) != (header->height > 0) ||
+        (header->height > 0 && (header->root_page == 0 || header->root_page >= header->page_count)))
+    {
+        releaseLogFileMapping(mapping, size);
+        printf("%s is not a valid index file.\n", path);
+        return 0;
+    }
+    if (header->log_count != (uint64_t)store->size || header->log_file_size != store->mapping_size ||
+        header->log_fingerprint != logStoreFingerprint(store))
+    {
+        releaseLogFileMapping(mapping, size);
+        printf("%s was not built from these logs.\n", path);
+        return 0;
+    }
+
+    index->mapping = mapping;
+    index->size = size;
+    index->header = header;
+    return 1;
+}
+
+
+// Function to find the rank of key in the index, the number of entries whose key is less than key,
+// reading one page per level
+// Returns 0 if a page of the index is damaged
+static inline int logIndexRank(const struct LogIndex *index, uint64_t key, uint64_t *rank)
+{
+    const struct LogIndexHeader *header = index->header;
+    uint64_t page = header->root_page;
+    *rank = 0;
+    if (header->height == 0)
+    {
+        return 1;
+    }
+
+    for (uint32_t level = header->height; level > 1; level--)
+    {
+        const struct LogIndexNode *node = (const struct LogIndexNode *)(index->mapping + page * LOG_INDEX_PAGE_SIZE);
+        if (node->count == 0 || node->count > LOG_INDEX_NODE_ENTRIES)
+        {
+            return 0;
+        }
+
+        // The last child whose first key is less than key holds the rank; the first child if there is none
+        uint32_t left = 0;
+        uint32_t right = node->count;
+        while (left < right)
+        {
+            uint32_t mid = left + (right - left) / 2;
+            if (node->keys[mid] < key)
+            {
+                left = mid + 1;
+            }
+            else
+            {
+                right = mid;
+            }
+        }
+        uint32_t child = left > 0 ? left - 1 : 0;
+        *rank += node->preceding[child];
+        page = node->children[child];
+        if (page == 0 || page >= header->page_count)
+        {
+            return 0;
+        }
+    }
+
+    const struct LogIndexLeaf *leaf = (const struct LogIndexLeaf *)(index->mapping + page * LOG_INDEX_PAGE_SIZE);
+    if (leaf->count == 0 || leaf->count > LOG_INDEX_LEAF_ENTRIES)
+    {
+        return 0;
+    }
+    uint32_t left = 0;
+    uint32_t right = leaf->count;
+    while (left < right)
+    {
+        uint32_t mid = left + (right - left) / 2;
+        if (leaf->keys[mid] < key)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    *rank += left;
+    return *rank <= header->entry_count;
+}
+
+
+// Function to read the entry at a rank of the index; the leaves are full, so its leaf and slot follow from the rank
+// Returns 0 if the rank is past the last entry or its leaf is damaged
+static inline int logIndexEntry(const struct LogIndex *index, uint64_t rank, uint64_t *key, int *row)
+{
+    const struct LogIndexHeader *header = index->header;
+    if (rank >= header->entry_count)
+    {
+        return 0;
+    }
+
+    uint64_t page = 1 + rank / LOG_INDEX_LEAF_ENTRIES;
+    uint32_t slot = (uint32_t)(rank % LOG_INDEX_LEAF_ENTRIES);
+    const struct LogIndexLeaf *leaf = (const struct LogIndexLeaf *)(index->mapping + page * LOG_INDEX_PAGE_SIZE);
+    if (page >= header->page_count || slot >= leaf->count || leaf->count > LOG_INDEX_LEAF_ENTRIES ||
+        leaf->rows[slot] < 0 || (uint64_t)leaf->rows[slot] >= header->log_count)
+    {
+        return 0;
+    }
+    *key = leaf->keys[slot];
+    *row = leaf->rows[slot];
+    return 1;
+}
+
+
+// Function to find the earliest occurrence of an issue code for a product of the store through the index in O(log N)
+// Sets *row to the row of the log in the store, or -1 if there is none
+// Returns 0, after saying so, if the index is damaged or its row is not a log of that product and issue code
+static inline int searchLogIndex(const struct LogIndex *index, const struct LogStore *store, int productID, int issueCode, int *row)
+{
+    *row = -1;
+    if (!fitsLogKey(productID, issueCode))
+    {
+        return 1;
+    }
+
+    uint64_t first = packLogKey(productID, issueCode, 0);
+    uint64_t rank;
+    uint64_t key;
+    int found_row;
+    if (!logIndexRank(index, first, &rank))
+    {
+        printf("The index file is damaged.\n");
+        return 0;
+    }
+    // Keys of the same product and issue code differ only in their low Batch Date & Time bits
+    if (logIndexEntry(index, rank, &key, &found_row) && key >> LOG_KEY_DATE_TIME_BITS == first >> LOG_KEY_DATE_TIME_BITS)
+    {
+        if (found_row >= store->size || productIssueOrderKey(store, found_row) != key)
+        {
+            printf("The index file is damaged.\n");
+            return 0;
+        }
+        *row = found_row;
+    }
+    return 1;
+}
+
+
+// Function to count the issues of a product through the index, as the difference of two ranks, in O(log N)
+// Returns 0, after saying so, if the index is damaged
+static inline int countLogIndex(const struct LogIndex *index, int productID, int *count)
+{
+    *count = 0;
+    if (!fitsLogKey(productID, 0))
+    {
+        return 1;
+    }
+
+    uint64_t first;
+    uint64_t end = index->header->entry_count;
+    if (!logIndexRank(index, packLogKey(productID, 0, 0), &first) ||
+        (productID + 1 < LOG_KEY_FIELD_LIMIT && !logIndexRank(index, packLogKey(productID + 1, 0, 0), &end)) ||
+        end < first)
+    {
+        printf("The index file is damaged.\n");
+        return 0;
+    }
+    *count = (int)(end - first);
+    return 1;
+}
+
+
+// Function to remove a "--index path" option from the arguments of a task program
+// Returns the path, or NULL if the option is not given
+static inline const char *takeIndexOption(int *argc, char *argv[])
+{
+    for (int i = 1; i + 1 < *argc; i++)
+    {
+        if (strcmp(argv[i], "--index") == 0)
+        {
+            const char *path = argv[i + 1];
+            for (int j = i; j + 2 <= *argc; j++)
+            {
+                argv[j] = argv[j + 2];
+            }
+            *argc -= 2;
+            return path;
+        }
+    }
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,673 @@
+/*
+Shared QA log store for the four task programs.
+
+The QA logs are kept as a structure of arrays: every numeric field of struct ProductionLine_Log is a contiguous
+column, Batch Date & Time is packed into 16 bits, and the Issue and Resolution descriptions are interned in a
+string pool, since the same few descriptions repeat for every occurrence of an issue code.
+A log takes 34 bytes in the store instead of the 224 bytes of struct ProductionLine_Log.
+
+The sort, group, search and count engines of the tasks read the columns they need directly from the store.
+A store may also be a view of a memory-mapped log file (see qa_log_file.h), in which case its columns and
+string pool point into the mapping until the store needs to grow.
+*/
+
+#ifndef QA_LOG_STORE_H
+#define QA_LOG_STORE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Define DateTime structure
+struct DateTime
+{
+    int dayofmonth;
+    int hourofday;
+    int minuteofhour;
+};
+
+// Define ProductionLine_Log structure
+struct ProductionLine_Log
+{
+    int LineCode;
+    int BatchCode;
+    struct DateTime BatchDateTime;
+    int ProductId;
+    int IssueCode;
+    char IssueDescription[100];
+    int ResolutionCode;
+    char ResolutionDescription[100];
+    int ReportingEmployeeId;
+};
+
+// Define a pool of interned strings: each distinct string is stored once and referred to by its id
+struct StringPool
+{
+    char *text;            // All strings one after another, each followed by '\0'
+    uint32_t text_size;
+    uint32_t text_capacity;
+    uint32_t *offsets;     // Start of each string id in text
+    int count;
+    int capacity;
+    int32_t *slots;        // Hash table of string ids, -1 when empty
+    unsigned int slot_capacity;
+};
+
+// Define the structure-of-arrays log store: column[i] holds the field of log i
+struct LogStore
+{
+    int32_t *LineCode;
+    int32_t *BatchCode;
+    uint16_t *BatchDateTime;        // Packed day of month (5 bits), hour (5 bits) and minute (6 bits)
+    int32_t *ProductId;
+    int32_t *IssueCode;
+    int32_t *IssueDescription;      // String pool id
+    int32_t *ResolutionCode;
+    int32_t *ResolutionDescription; // String pool id
+    int32_t *ReportingEmployeeId;
+    int size;
+    int capacity;
+    struct StringPool strings;
+    void *mapping;                                        // File mapping the columns point into, NULL when they are on the heap
+    size_t mapping_size;
+    void (*release_mapping)(void *mapping, size_t size);
+};
+
+// Initial number of logs and string slots of a store
+#define LOG_STORE_INITIAL_CAPACITY 1024
+#define STRING_POOL_INITIAL_CAPACITY 64
+
+
+// Function to pack Batch Date & Time into 16 bits (day 5 bits, hour 5 bits, minute 6 bits)
+// Returns -1 if a field is out of range
+static inline int packDateTime(const struct DateTime *date_time)
+{
+    if (date_time->dayofmonth < 0 || date_time->dayofmonth >= 32 ||
+        date_time->hourofday < 0 || date_time->hourofday >= 32 ||
+        date_time->minuteofhour < 0 || date_time->minuteofhour >= 64)
+    {
+        return -1;
+    }
+    return (date_time->dayofmonth << 11) | (date_time->hourofday << 6) | date_time->minuteofhour;
+}
+
+
+// Function to unpack a 16-bit Batch Date & Time
+static inline struct DateTime unpackDateTime(uint16_t packed_date_time)
+{
+    struct DateTime date_time = {packed_date_time >> 11, (packed_date_time >> 6) & 31, packed_date_time & 63};
+    return date_time;
+}
+
+
+// Function to hash a string (FNV-1a)
+static inline uint32_t hashString(const char *text)
+{
+    uint32_t hash = 2166136261u;
+    while (*text != '\0')
+    {
+        hash = (hash ^ (unsigned char)*text++) * 16777619u;
+    }
+    return hash;
+}
+
+
+// Function to return the text of a string pool id
+static inline const char *poolString(const struct StringPool *pool, int32_t id)
+{
+    return pool->text + pool->offsets[id];
+}
+
+
+// Function to release a string pool
+static inline void freeStringPool(struct StringPool *pool)
+{
+    free(pool->text);
+    free(pool->offsets);
+    free(pool->slots);
+    memset(pool, 0, sizeof(struct StringPool));
+}
+
+
+// Function to double the hash table of a string pool and re-insert its ids
+// A pool without a hash table, such as one read from a log file, gets one at most half full
+static inline int growStringSlots(struct StringPool *pool)
+{
+    unsigned int capacity = pool->slot_capacity > 0 ? 2 * pool->slot_capacity : STRING_POOL_INITIAL_CAPACITY;
+    while (capacity < 2 * (unsigned int)(pool->count + 1))
+    {
+        capacity *= 2;
+    }
+    int32_t *slots = (int32_t *)malloc(capacity * sizeof(int32_t));
+    if (slots == NULL)
+    {
+        return 0;
+    }
+    memset(slots, -1, capacity * sizeof(int32_t));
+
+    for (int id = 0; id < pool->count; id++)
+    {
+        unsigned int slot = hashString(poolString(pool, id)) & (capacity - 1);
+        while (slots[slot] != -1)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        slots[slot] = id;
+    }
+
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_capacity = capacity;
+    return 1;
+}
+
+
+// Function to intern a string: returns the id of an equal string already in the pool, or adds it
+// Returns -1 if memory could not be allocated
+static inline int32_t internString(struct StringPool *pool, const char *text)
+{
+    // Keep the hash table at most half full
+    if (2 * (unsigned int)(pool->count + 1) > pool->slot_capacity && !growStringSlots(pool))
+    {
+        return -1;
+    }
+
+    // Linear probing until an equal string or an empty slot is found
+    unsigned int slot = hashString(text) & (pool->slot_capacity - 1);
+    while (pool->slots[slot] != -1)
+    {
+        if (strcmp(poolString(pool, pool->slots[slot]), text) == 0)
+        {
+            return pool->slots[slot];
+        }
+        slot = (slot + 1) & (pool->slot_capacity - 1);
+    }
+
+    // Make room for the new string and its offset
+    size_t length = strlen(text) + 1;
+    if ((uint64_t)pool->text_size + length > UINT32_MAX)
+    {
+        return -1;
+    }
+    if (pool->text_size + length > pool->text_capacity)
+    {
+        uint64_t capacity = pool->text_capacity > 0 ? pool->text_capacity : 1024;
+        while (capacity < pool->text_size + length)
+        {
+            capacity *= 2;
+        }
+        capacity = capacity < UINT32_MAX ? capacity : UINT32_MAX;
+        char *grown = (char *)realloc(pool->text, (size_t)capacity);
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        pool->text = grown;
+        pool->text_capacity = (uint32_t)capacity;
+    }
+    if (pool->count == pool->capacity)
+    {
+        int capacity = pool->capacity > 0 ? 2 * pool->capacity : STRING_POOL_INITIAL_CAPACITY;
+        uint32_t *grown = (uint32_t *)realloc(pool->offsets, (size_t)capacity * sizeof(uint32_t));
+        if (grown == NULL)
+        {
+            return -1;
+        }
+        pool->offsets = grown;
+        pool->capacity = capacity;
+    }
+
+    memcpy(pool->text + pool->text_size, text, length);
+    pool->offsets[pool->count] = pool->text_size;
+    pool->text_size += (uint32_t)length;
+    pool->slots[slot] = pool->count;
+    return pool->count++;
+}
+
+
+// Function to create an empty log store
+static inline void initLogStore(struct LogStore *store)
+{
+    memset(store, 0, sizeof(struct LogStore));
+}
+
+
+// Function to release a log store
+static inline void freeLogStore(struct LogStore *store)
+{
+    // The columns and strings of a mapped store belong to the mapping
+    if (store->mapping != NULL)
+    {
+        store->release_mapping(store->mapping, store->mapping_size);
+        free(store->strings.slots);
+        initLogStore(store);
+        return;
+    }
+
+    free(store->LineCode);
+    free(store->BatchCode);
+    free(store->BatchDateTime);
+    free(store->ProductId);
+    free(store->IssueCode);
+    free(store->IssueDescription);
+    free(store->ResolutionCode);
+    free(store->ResolutionDescription);
+    free(store->ReportingEmployeeId);
+    freeStringPool(&store->strings);
+    initLogStore(store);
+}
+
+
+// Function to resize one column of the store to capacity elements
+static inline int resizeColumn(void **column, size_t element_size, int capacity)
+{
+    void *resized = realloc(*column, (size_t)capacity * element_size);
+    if (resized == NULL)
+    {
+        return 0;
+    }
+    *column = resized;
+    return 1;
+}
+
+
+// Function to copy a column of size elements into a new heap array of capacity elements
+static inline void *copyColumn(const void *column, size_t element_size, int size, int capacity)
+{
+    void *copy = malloc((size_t)(capacity > 0 ? capacity : 1) * element_size);
+    if (copy != NULL && size > 0)
+    {
+        memcpy(copy, column, (size_t)size * element_size);
+    }
+    return copy;
+}
+
+
+// Function to move the columns and strings of a mapped store onto the heap, with room for capacity logs,
+// and release the mapping
+// Returns 0 if memory could not be allocated, in which case the store is still mapped
+static inline int detachLogStore(struct LogStore *store, int capacity)
+{
+    struct LogStore heap = *store;
+    capacity = capacity > store->size ? capacity : store->size;
+
+    heap.LineCode = (int32_t *)copyColumn(store->LineCode, sizeof(int32_t), store->size, capacity);
+    heap.BatchCode = (int32_t *)copyColumn(store->BatchCode, sizeof(int32_t), store->size, capacity);
+    heap.BatchDateTime = (uint16_t *)copyColumn(store->BatchDateTime, sizeof(uint16_t), store->size, capacity);
+    heap.ProductId = (int32_t *)copyColumn(store->ProductId, sizeof(int32_t), store->size, capacity);
+    heap.IssueCode = (int32_t *)copyColumn(store->IssueCode, sizeof(int32_t), store->size, capacity);
+    heap.IssueDescription = (int32_t *)copyColumn(store->IssueDescription, sizeof(int32_t), store->size, capacity);
+    heap.ResolutionCode = (int32_t *)copyColumn(store->ResolutionCode, sizeof(int32_t), store->size, capacity);
+    heap.ResolutionDescription = (int32_t *)copyColumn(store->ResolutionDescription, sizeof(int32_t), store->size, capacity);
+    heap.ReportingEmployeeId = (int32_t *)copyColumn(store->ReportingEmployeeId, sizeof(int32_t), store->size, capacity);
+    heap.capacity = capacity;
+
+    // The hash table of the pool, if any, is already on the heap
+    heap.strings.text = (char *)copyColumn(store->strings.text, 1, (int)store->strings.text_size, (int)store->strings.text_size);
+    heap.strings.text_capacity = store->strings.text_size;
+    heap.strings.offsets = (uint32_t *)copyColumn(store->strings.offsets, sizeof(uint32_t), store->strings.count, store->strings.count);
+    heap.strings.capacity = store->strings.count;
+
+    heap.mapping = NULL;
+    heap.mapping_size = 0;
+    heap.release_mapping = NULL;
+
+    if (heap.LineCode == NULL || heap.BatchCode == NULL || heap.BatchDateTime == NULL || heap.ProductId == NULL ||
+        heap.IssueCode == NULL || heap.IssueDescription == NULL || heap.ResolutionCode == NULL ||
+        heap.ResolutionDescription == NULL || heap.ReportingEmployeeId == NULL ||
+        heap.strings.text == NULL || heap.strings.offsets == NULL)
+    {
+        heap.strings.slots = NULL; // Still owned by the mapped store
+        freeLogStore(&heap);
+        return 0;
+    }
+
+    store->release_mapping(store->mapping, store->mapping_size);
+    *store = heap;
+    return 1;
+}
+
+
+// Function to make room for at least capacity logs in the store
+// Returns 0 if memory could not be allocated, in which case the store keeps its previous capacity
+static inline int reserveLogStore(struct LogStore *store, int capacity)
+{
+    // A mapped store is moved onto the heap before it can grow
+    if (store->mapping != NULL)
+    {
+        return detachLogStore(store, capacity);
+    }
+
+    if (capacity <= store->capacity)
+    {
+        return 1;
+    }
+
+    // Columns already resized keep the larger size, so a failure part-way leaves every column usable
+    int ok = resizeColumn((void **)&store->LineCode, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->BatchCode, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->BatchDateTime, sizeof(uint16_t), capacity) &&
+             resizeColumn((void **)&store->ProductId, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->IssueCode, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->IssueDescription, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->ResolutionCode, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->ResolutionDescription, sizeof(int32_t), capacity) &&
+             resizeColumn((void **)&store->ReportingEmployeeId, sizeof(int32_t), capacity);
+
+    if (ok)
+    {
+        store->capacity = capacity;
+    }
+    return ok;
+}
+
+
+// Function to append a log to the store
+// Returns 0 if memory could not be allocated or Batch Date & Time is out of range
+static inline int appendLog(struct LogStore *store, const struct ProductionLine_Log *log)
+{
+    int packed_date_time = packDateTime(&log->BatchDateTime);
+    if (packed_date_time < 0)
+    {
+        return 0;
+    }
+
+    if (store->size == store->capacity &&
+        !reserveLogStore(store, store->capacity > 0 ? 2 * store->capacity : LOG_STORE_INITIAL_CAPACITY))
+    {
+        return 0;
+    }
+
+    int32_t issue_description = internString(&store->strings, log->IssueDescription);
+    int32_t resolution_description = internString(&store->strings, log->ResolutionDescription);
+    if (issue_description < 0 || resolution_description < 0)
+    {
+        return 0;
+    }
+
+    int row = store->size++;
+    store->LineCode[row] = log->LineCode;
+    store->BatchCode[row] = log->BatchCode;
+    store->BatchDateTime[row] = (uint16_t)packed_date_time;
+    store->ProductId[row] = log->ProductId;
+    store->IssueCode[row] = log->IssueCode;
+    store->IssueDescription[row] = issue_description;
+    store->ResolutionCode[row] = log->ResolutionCode;
+    store->ResolutionDescription[row] = resolution_description;
+    store->ReportingEmployeeId[row] = log->ReportingEmployeeId;
+    return 1;
+}
+
+
+// Function to append an array of logs to the store
+// Returns 0 and prints the failing log if a log could not be added
+static inline int loadLogStore(struct LogStore *store, const struct ProductionLine_Log logs_data[], int logs_number)
+{
+    if (!reserveLogStore(store, store->size + logs_number))
+    {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+
+    for (int i = 0; i < logs_number; i++)
+    {
+        if (!appendLog(store, &logs_data[i]))
+        {
+            printf("Log %d could not be stored: Batch Date & Time out of range or memory allocation failed.\n", i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+// Function to append every log of the store src to the store dest, interning the descriptions of src into dest
+// Returns 0 if memory could not be allocated, in which case dest may hold some of the logs of src
+static inline int appendLogStore(struct LogStore *dest, const struct LogStore *src)
+{
+    if (src->size == 0)
+    {
+        return 1;
+    }
+    if ((int64_t)dest->size + src->size > INT32_MAX)
+    {
+        return 0;
+    }
+
+    // Grow geometrically so that appending many small stores stays linear
+    int capacity = dest->size + src->size;
+    if (capacity > dest->capacity && dest->capacity <= INT32_MAX / 2 && 2 * dest->capacity > capacity)
+    {
+        capacity = 2 * dest->capacity;
+    }
+    if (!reserveLogStore(dest, capacity))
+    {
+        return 0;
+    }
+
+    // Map each string id of src to the id of the same string in dest
+    int32_t *string_ids = (int32_t *)malloc((size_t)(src->strings.count > 0 ? src->strings.count : 1) * sizeof(int32_t));
+    if (string_ids == NULL)
+    {
+        return 0;
+    }
+    for (int id = 0; id < src->strings.count; id++)
+    {
+        string_ids[id] = internString(&dest->strings, poolString(&src->strings, id));
+        if (string_ids[id] < 0)
+        {
+            free(string_ids);
+            return 0;
+        }
+    }
+
+    int row = dest->size;
+    size_t column_size = (size_t)src->size * sizeof(int32_t);
+    memcpy(dest->LineCode + row, src->LineCode, column_size);
+    memcpy(dest->BatchCode + row, src->BatchCode, column_size);
+    memcpy(dest->BatchDateTime + row, src->BatchDateTime, (size_t)src->size * sizeof(uint16_t));
+    memcpy(dest->ProductId + row, src->ProductId, column_size);
+    memcpy(dest->IssueCode + row, src->IssueCode, column_size);
+    memcpy(dest->ResolutionCode + row, src->ResolutionCode, column_size);
+    memcpy(dest->ReportingEmployeeId + row, src->ReportingEmployeeId, column_size);
+    for (int i = 0; i < src->size; i++)
+    {
+        dest->IssueDescription[row + i] = string_ids[src->IssueDescription[i]];
+        dest->ResolutionDescription[row + i] = string_ids[src->ResolutionDescription[i]];
+    }
+    dest->size += src->size;
+
+    free(string_ids);
+    return 1;
+}
+
+
+// Function to rebuild the full record of log row from the store
+static inline void getLogRecord(const struct LogStore *store, int row, struct ProductionLine_Log *log)
+{
+    log->LineCode = store->LineCode[row];
+    log->BatchCode = store->BatchCode[row];
+    log->BatchDateTime = unpackDateTime(store->BatchDateTime[row]);
+    log->ProductId = store->ProductId[row];
+    log->IssueCode = store->IssueCode[row];
+    snprintf(log->IssueDescription, sizeof(log->IssueDescription), "%s", poolString(&store->strings, store->IssueDescription[row]));
+    log->ResolutionCode = store->ResolutionCode[row];
+    snprintf(log->ResolutionDescription, sizeof(log->ResolutionDescription), "%s", poolString(&store->strings, store->ResolutionDescription[row]));
+    log->ReportingEmployeeId = store->ReportingEmployeeId[row];
+}
+
+
+// Function to rebuild the full records of every log of the store into a new array
+// Returns the array (to be freed by the caller), or NULL if memory could not be allocated
+static inline struct ProductionLine_Log *copyLogRecords(const struct LogStore *store)
+{
+    struct ProductionLine_Log *logs_data = (struct ProductionLine_Log *)malloc((size_t)(store->size > 0 ? store->size : 1) * sizeof(struct ProductionLine_Log));
+    if (logs_data == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < store->size; i++)
+    {
+        getLogRecord(store, i, &logs_data[i]);
+    }
+    return logs_data;
+}
+
+
+// Function to reorder one 4-byte column so that row i holds the value of row order[i]
+static inline void permuteColumn32(int32_t column[], const int order[], int size, int32_t scratch[])
+{
+    for (int i = 0; i < size; i++)
+    {
+        scratch[i] = column[order[i]];
+    }
+    memcpy(column, scratch, (size_t)size * sizeof(int32_t));
+}
+
+
+// Function to reorder the logs of the store so that row i holds the log previously at row order[i]
+// Every column is gathered through one scratch column, moving 34 bytes per log in total
+// Returns 0 if the scratch column could not be allocated, in which case the store is unchanged
+static inline int permuteLogStore(struct LogStore *store, const int order[])
+{
+    int32_t *scratch = (int32_t *)malloc((size_t)(store->size > 0 ? store->size : 1) * sizeof(int32_t));
+    if (scratch == NULL)
+    {
+        return 0;
+    }
+
+    permuteColumn32(store->LineCode, order, store->size, scratch);
+    permuteColumn32(store->BatchCode, order, store->size, scratch);
+    permuteColumn32(store->ProductId, order, store->size, scratch);
+    permuteColumn32(store->IssueCode, order, store->size, scratch);
+    permuteColumn32(store->IssueDescription, order, store->size, scratch);
+    permuteColumn32(store->ResolutionCode, order, store->size, scratch);
+    permuteColumn32(store->ResolutionDescription, order, store->size, scratch);
+    permuteColumn32(store->ReportingEmployeeId, order, store->size, scratch);
+
+    // Batch Date & Time is the only 2-byte column
+    uint16_t *date_times = (uint16_t *)scratch;
+    for (int i = 0; i < store->size; i++)
+    {
+        date_times[i] = store->BatchDateTime[order[i]];
+    }
+    memcpy(store->BatchDateTime, date_times, (size_t)store->size * sizeof(uint16_t));
+
+    free(scratch);
+    return 1;
+}
+
+
+// Function to load the example QA logs used by all four task programs into the store
+static inline int loadExampleLogs(struct LogStore *store)
+{
+    // Example ProductionLine_Log array
+    static const struct ProductionLine_Log logs_data[] =
+    {
+        {1, 101, {1, 20, 45}, 1001, 10, "Defect in wing", 10, "Resolved by replacing faulty component", 100},
+        {2, 102, {1, 5, 45}, 1003, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
+        {5, 105, {1, 11, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
+        {1, 107, {1, 7, 45}, 1001, 1, "Product damage", 1, "Resolved by adding final quality checks", 100},
+        {9, 102, {1, 16, 45}, 1003, 3, "Shipping delay", 3, "Resolved by increasing number of couriers", 105},
+        {6, 103, {1, 23, 45}, 1005, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
+        {1, 111, {1, 10, 45}, 1001, 17, "Transportation issue", 17, "Resolved by improving transportation methods", 100},
+        {3, 116, {1, 6, 45}, 1006, 20, "Customer complaint", 20, "Resolved with personalised solutions", 105},
+        {1, 109, {1, 22, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
+        {8, 107, {1, 21, 45}, 1005, 6, "Labelling issue", 6, "Resolved by implementing revised labelling procedures", 100},
+        {7, 112, {1, 18, 45}, 1001, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
+        {1, 108, {1, 4, 45}, 1007, 30, "Staff shortage", 30, "Resolved by hiring temporary staff", 102},
+    };
+
+    // Determine the number of logs in the array to ensure that the logs_number variable holds the correct number of logs, even if the size of the array changes in the future
+    int logs_number = sizeof(logs_data) / sizeof(logs_data[0]);
+
+    return loadLogStore(store, logs_data, logs_number);
+}
+
+
+// Function to read the wall-clock time in milliseconds
+static inline double currentTimeMs(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+
+// Function to return the next number of a xorshift pseudo-random sequence
+static inline uint64_t nextRandom(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+
+// Function to find the number of processors to use when no thread count is given
+static inline int defaultThreadCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    int processors = (int)system_info.dwNumberOfProcessors;
+#else
+    int processors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return processors > 0 ? processors : 1;
+}
+
+
+// Function to fill in a synthetic log for one of products 1000-1999, issue codes 1-50 and lines 1-4 over a month
+static inline void generateLog(struct ProductionLine_Log *log, uint64_t *random_state)
+{
+    log->LineCode = 1 + (int)(nextRandom(random_state) % 4);
+    log->BatchCode = 100 + (int)(nextRandom(random_state) % 900);
+    log->BatchDateTime.dayofmonth = 1 + (int)(nextRandom(random_state) % 31);
+    log->BatchDateTime.hourofday = (int)(nextRandom(random_state) % 24);
+    log->BatchDateTime.minuteofhour = (int)(nextRandom(random_state) % 60);
+    log->ProductId = 1000 + (int)(nextRandom(random_state) % 1000);
+    log->IssueCode = 1 + (int)(nextRandom(random_state) % 50);
+    log->ResolutionCode = log->IssueCode;
+    log->ReportingEmployeeId = 100 + (int)(nextRandom(random_state) % 10);
+
+    // Descriptions repeat per issue code, as in the real logs
+    snprintf(log->IssueDescription, sizeof(log->IssueDescription), "Issue %d", log->IssueCode);
+    snprintf(log->ResolutionDescription, sizeof(log->ResolutionDescription), "Resolution %d", log->ResolutionCode);
+}
+
+
+// Function to append logs_number synthetic logs for products 1000-1999 and issue codes 1-50 over a month to the store
+// Returns 0 if memory could not be allocated
+static inline int generateLogs(struct LogStore *store, int logs_number, uint64_t *random_state)
+{
+    if (!reserveLogStore(store, store->size + logs_number))
+    {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+
+    struct ProductionLine_Log log;
+    for (int i = 0; i < logs_number; i++)
+    {
+        generateLog(&log, random_state);
+        if (!appendLog(store, &log))
+        {
+            printf("Memory allocation failed.\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+QA log file tool.
+
+Creates the binary monthly log files (.qalog) that the four task programs open with --logs, so that a month of
+logs is loaded by mapping the file instead of rebuilding the log store on every run, and converts between them and
+the CSV exports of the line controllers.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_log_csv.h"
+#include "qa_archive.h"
+#include "qa_log_index.h"
+
+// Usage: qa_log_tool example out.qalog | generate rows out.qalog [seed] | import in.csv out.qalog [threads] | export in.qalog out.csv | archive manifest YYYY-MM in.qalog|in.csv | index in.qalog out.qaidx
+// example  - write the example logs of the task programs
+// generate - write a synthetic log of rows logs
+// import   - parse a CSV export on several threads (default: one per processor) and write its logs
+// export   - write the logs of a log file as CSV
+// archive  - add a month of logs to the archive described by manifest (created if needed), see qa_archive.h
+// index    - write the B+-tree index of a log file that task3 and task4 open with --index, see qa_log_index.h
+// The time spent building and writing the file is written to stderr
+// Build with -pthread
+int main(int argc, char *argv[])
+{
+    struct LogStore store;
+    initLogStore(&store);
+
+    int loaded = 0;
+    const char *path = NULL;
+    if (argc == 3 && strcmp(argv[1], "example") == 0)
+    {
+        path = argv[2];
+        loaded = loadExampleLogs(&store);
+    }
+    else if ((argc == 4 || argc == 5) && strcmp(argv[1], "generate") == 0)
+    {
+        int rows = atoi(argv[2]);
+        uint64_t random_state = argc == 5 ? strtoull(argv[4], NULL, 10) : 88172645463325252ULL;
+        path = argv[3];
+        if (rows < 1 || random_state == 0)
+        {
+            printf("Rows must be at least 1 and the seed must not be 0.\n");
+            return 1;
+        }
+        loaded = generateLogs(&store, rows, &random_state);
+    }
+    else if ((argc == 4 || argc == 5) && strcmp(argv[1], "import") == 0)
+    {
+        int thread_count = argc == 5 ? atoi(argv[4]) : defaultThreadCount();
+        path = argv[3];
+        if (thread_count < 1)
+        {
+            printf("Thread count must be at least 1.\n");
+            return 1;
+        }
+        loaded = readLogCsv(&store, argv[2], thread_count);
+    }
+    else if (argc == 4 && strcmp(argv[1], "export") == 0)
+    {
+        int exported = mapLogFile(&store, argv[2]) && writeLogCsv(&store, argv[3]);
+        freeLogStore(&store);
+        return !exported;
+    }
+    else if (argc == 5 && strcmp(argv[1], "archive") == 0)
+    {
+        int month = parseArchiveMonth(argv[3]);
+        if (month < 0)
+        {
+            printf("Month must be written YYYY-MM.\n");
+            return 1;
+        }
+        int added = isLogFilePath(argv[4]) ? mapLogFile(&store, argv[4]) : readLogCsv(&store, argv[4], defaultThreadCount());
+        double start = currentTimeMs();
+        added = added && addArchiveMonth(argv[2], month, &store);
+        if (added)
+        {
+            fprintf(stderr, "Archived %d logs of %s in %s in %.3f ms\n", store.size, argv[3], argv[2], currentTimeMs() - start);
+        }
+        freeLogStore(&store);
+        return !added;
+    }
+    else if (argc == 4 && strcmp(argv[1], "index") == 0)
+    {
+        double start = currentTimeMs();
+        int indexed = mapLogFile(&store, argv[2]) && writeLogIndex(&store, argv[3]);
+        if (indexed)
+        {
+            fprintf(stderr, "Indexed %d logs of %s in %s in %.3f ms\n", store.size, argv[2], argv[3], currentTimeMs() - start);
+        }
+        freeLogStore(&store);
+        return !indexed;
+    }
+    else
+    {
+        printf("Usage: %s example out.qalog | generate rows out.qalog [seed] | import in.csv out.qalog [threads] | export in.qalog out.csv | archive manifest YYYY-MM in.qalog|in.csv | index in.qalog out.qaidx\n", argv[0]);
+        return 1;
+    }
+
+    if (!loaded)
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+
+    double start = currentTimeMs();
+    int written = writeLogFile(&store, path);
+    if (written)
+    {
+        fprintf(stderr, "Wrote %d logs to %s in %.3f ms\n", store.size, path, currentTimeMs() - start);
+    }
+
+    freeLogStore(&store);
+    return !written;
+}
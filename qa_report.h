@@ -0,0 +1,260 @@
+/*
+Buffered report writer for the task programs.
+
+A sorted report runs to several lines per log, and once the sort itself is fast, formatting it with one printf call
+per field spends most of the time parsing format strings and locking stdout. A ReportWriter formats the fields
+itself, integers two digits at a time, into one large reusable buffer, and hands the buffer to the operating system
+with a single write() each time it fills, bypassing stdio.
+
+Reports can be written in three formats, chosen with --format:
+
+    text   - the report layout of the task programs (default)
+    csv    - a header line naming the fields, then one line per log
+    binary - REPORT_BINARY_MAGIC and the number of fields as a uint32, then the fields of every log as int32 values,
+             all in the byte order of the machine that wrote them
+
+Anything printed to stdout before a writer is opened is flushed first, so the two can be mixed as long as nothing is
+printed while a writer is open.
+*/
+
+#ifndef QA_REPORT_H
+#define QA_REPORT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+#define REPORT_WRITER_BUFFER (1 << 20)
+#define REPORT_WRITER_FALLBACK_BUFFER 4096
+#define REPORT_BINARY_MAGIC "QARPTV1"
+
+// Define the output formats of a report
+enum ReportFormat
+{
+    REPORT_TEXT,
+    REPORT_CSV,
+    REPORT_BINARY
+};
+
+// Define a report writer: formatted output collects in buffer until it is written to fd in one call
+struct ReportWriter
+{
+    char *buffer;
+    size_t size;
+    size_t capacity;
+    int fd;
+    int failed;
+    enum ReportFormat format;
+    char fallback[REPORT_WRITER_FALLBACK_BUFFER]; // Used if the large buffer cannot be allocated
+};
+
+
+// Function to write the buffered output and empty the buffer
+// A failed write is remembered and reported when the writer is closed
+static inline void flushReportWriter(struct ReportWriter *writer)
+{
+    const char *data = writer->buffer;
+    size_t remaining = writer->size;
+
+    while (remaining > 0 && !writer->failed)
+    {
+#ifdef _WIN32
+        int written = _write(writer->fd, data, remaining < (1u << 30) ? (unsigned int)remaining : (1u << 30));
+#else
+        ssize_t written = write(writer->fd, data, remaining);
+#endif
+        if (written <= 0)
+        {
+            writer->failed = 1;
+            break;
+        }
+        data += written;
+        remaining -= (size_t)written;
+    }
+    writer->size = 0;
+}
+
+
+// Function to open a report writer on stdout, after flushing whatever stdio has buffered for it
+static inline void openReportWriter(struct ReportWriter *writer, enum ReportFormat format)
+{
+    fflush(stdout);
+    writer->buffer = (char *)malloc(REPORT_WRITER_BUFFER);
+    writer->capacity = REPORT_WRITER_BUFFER;
+    if (writer->buffer == NULL)
+    {
+        writer->buffer = writer->fallback;
+        writer->capacity = REPORT_WRITER_FALLBACK_BUFFER;
+    }
+    writer->size = 0;
+    writer->failed = 0;
+    writer->format = format;
+#ifdef _WIN32
+    writer->fd = _fileno(stdout);
+    if (format == REPORT_BINARY)
+    {
+        _setmode(writer->fd, _O_BINARY);
+    }
+#else
+    writer->fd = fileno(stdout);
+#endif
+}
+
+
+// Function to write out and release a report writer
+// Returns 0, after saying so on stderr, if any of the report could not be written
+static inline int closeReportWriter(struct ReportWriter *writer)
+{
+    flushReportWriter(writer);
+    if (writer->buffer != writer->fallback)
+    {
+        free(writer->buffer);
+    }
+    writer->buffer = NULL;
+
+    if (writer->failed)
+    {
+        fprintf(stderr, "Could not write the report.\n");
+        return 0;
+    }
+    return 1;
+}
+
+
+// Function to append size bytes to the report
+static inline void reportBytes(struct ReportWriter *writer, const void *data, size_t size)
+{
+    if (writer->capacity - writer->size < size)
+    {
+        flushReportWriter(writer);
+        if (size > writer->capacity)
+        {
+            // Larger than the whole buffer: write it straight through
+            char *saved = writer->buffer;
+            writer->buffer = (char *)data;
+            writer->size = size;
+            flushReportWriter(writer);
+            writer->buffer = saved;
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->size, data, size);
+    writer->size += size;
+}
+
+
+// Function to append a string to the report
+static inline void reportText(struct ReportWriter *writer, const char *text)
+{
+    reportBytes(writer, text, strlen(text));
+}
+
+
+// Function to append one character to the report
+static inline void reportChar(struct ReportWriter *writer, char c)
+{
+    if (writer->size == writer->capacity)
+    {
+        flushReportWriter(writer);
+    }
+    writer->buffer[writer->size++] = c;
+}
+
+
+// Function to append an integer to the report in decimal
+// Digits are produced two at a time from a table, right to left, into a small scratch buffer
+static inline void reportInt(struct ReportWriter *writer, int value)
+{
+    static const char digit_pairs[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    char digits[12];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+
+    while (magnitude >= 100)
+    {
+        uint32_t pair = magnitude % 100;
+        magnitude /= 100;
+        start -= 2;
+        memcpy(start, &digit_pairs[2 * pair], 2);
+    }
+    if (magnitude >= 10)
+    {
+        start -= 2;
+        memcpy(start, &digit_pairs[2 * magnitude], 2);
+    }
+    else
+    {
+        *--start = (char)('0' + magnitude);
+    }
+    if (value < 0)
+    {
+        *--start = '-';
+    }
+
+    reportBytes(writer, start, (size_t)(end - start));
+}
+
+
+// Function to append an int32 value to a binary report
+static inline void reportInt32(struct ReportWriter *writer, int32_t value)
+{
+    reportBytes(writer, &value, sizeof(value));
+}
+
+
+// Function to start a binary report of field_count int32 fields per log
+static inline void reportBinaryHeader(struct ReportWriter *writer, uint32_t field_count)
+{
+    reportBytes(writer, REPORT_BINARY_MAGIC, sizeof(REPORT_BINARY_MAGIC));
+    reportBytes(writer, &field_count, sizeof(field_count));
+}
+
+
+// Function to find and remove a "--format text|csv|binary" option from the arguments of a task program
+// Returns the format, REPORT_TEXT when the option is absent, or -1 for an unknown format
+static inline int takeFormatOption(int *argc, char *argv[])
+{
+    for (int i = 1; i + 1 < *argc; i++)
+    {
+        if (strcmp(argv[i], "--format") == 0)
+        {
+            const char *name = argv[i + 1];
+            for (int j = i; j + 2 <= *argc; j++)
+            {
+                argv[j] = argv[j + 2];
+            }
+            *argc -= 2;
+
+            if (strcmp(name, "text") == 0)
+            {
+                return REPORT_TEXT;
+            }
+            if (strcmp(name, "csv") == 0)
+            {
+                return REPORT_CSV;
+            }
+            if (strcmp(name, "binary") == 0)
+            {
+                return REPORT_BINARY;
+            }
+            printf("Unknown report format: %s (expected text, csv or binary)\n", name);
+            return -1;
+        }
+    }
+    return REPORT_TEXT;
+}
+
+#endif
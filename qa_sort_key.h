@@ -0,0 +1,438 @@
+/*
+Sort keys generated at compile time from a list of log fields.
+
+A report order is written once as a list of ProductionLine_Log fields, most significant first, each with the number
+of bits it takes in a packed 64-bit key:
+
+    #define PRODUCT_ISSUE_ORDER(FIELD) FIELD(PRODUCT_ID, 24) FIELD(ISSUE_CODE, 24) FIELD(BATCH_DATE_TIME, 16)
+    DEFINE_SORT_KEY(productIssueOrder, PRODUCT_ISSUE_ORDER)
+
+DEFINE_SORT_KEY then generates, for that order only:
+
+    name##Key(store, row)          - the packed key of a log of the store; comparing keys compares the logs
+    name##Fits(store, row)         - whether every field of the log fits into its bits, so that the key is exact
+    name##KeyOf(fields)            - the packed key of loose field values, such as the first key of a search
+    name##FitsFields(fields)       - whether every field of loose values fits into its bits
+    name##Unpack(key, log)         - the fields of a packed key, written back into a log
+    name##Compare(a, b)            - exact three-way comparison of two ProductionLine_Log records
+    name##CompareRows(store, a, b) - exact three-way comparison of two logs of the store
+
+The fields are expanded in line with constant shifts and masks, so the key is built with shifts and ors and the
+comparisons without a branch per field; a generated order is as fast as one written by hand. An order whose fields
+need more than 64 bits, or a field given no bits or more than 32, is a compile error.
+
+A field of 32 bits holds any int, its sign bit flipped so that keys compare in signed order; a narrower field holds
+values from 0 to 2^bits - 1, which name##Fits checks. Batch Date & Time is the packed date and time of the store
+(16 bits for any valid date and time). Adding a field means adding its FIELD_ macros below.
+
+The packed log key of the search, archive and index files is PRODUCT_ISSUE_ORDER, defined here once: packLogKey()
+and fitsLogKey() are its loose-value form, and the key widths are the LOG_KEY_ constants its list is written with.
+The (packed log key, row) entries of task 1's index sorts are here too, so that task 3's search index, the archive
+and the index file writer sort their logs with the same O(N) radix sort (sortLogKeyEntries) instead of each keeping
+a comparator of its own.
+*/
+
+#ifndef QA_SORT_KEY_H
+#define QA_SORT_KEY_H
+
+#include "qa_log_store.h"
+#include "qa_trace.h"
+
+// Field of a log of the store, as an int
+#define SORT_FIELD_STORE_LINE_CODE(store, row) ((store)->LineCode[row])
+#define SORT_FIELD_STORE_BATCH_CODE(store, row) ((store)->BatchCode[row])
+#define SORT_FIELD_STORE_BATCH_DATE_TIME(store, row) ((int)(store)->BatchDateTime[row])
+#define SORT_FIELD_STORE_PRODUCT_ID(store, row) ((store)->ProductId[row])
+#define SORT_FIELD_STORE_ISSUE_CODE(store, row) ((store)->IssueCode[row])
+#define SORT_FIELD_STORE_RESOLUTION_CODE(store, row) ((store)->ResolutionCode[row])
+#define SORT_FIELD_STORE_REPORTING_EMPLOYEE_ID(store, row) ((store)->ReportingEmployeeId[row])
+
+// Three-way comparison of a field of two ProductionLine_Log records
+#define SORT_FIELD_COMPARE_LINE_CODE(a, b) compareSortField((a)->LineCode, (b)->LineCode)
+#define SORT_FIELD_COMPARE_BATCH_CODE(a, b) compareSortField((a)->BatchCode, (b)->BatchCode)
+#define SORT_FIELD_COMPARE_BATCH_DATE_TIME(a, b) compareSortDateTimes(&(a)->BatchDateTime, &(b)->BatchDateTime)
+#define SORT_FIELD_COMPARE_PRODUCT_ID(a, b) compareSortField((a)->ProductId, (b)->ProductId)
+#define SORT_FIELD_COMPARE_ISSUE_CODE(a, b) compareSortField((a)->IssueCode, (b)->IssueCode)
+#define SORT_FIELD_COMPARE_RESOLUTION_CODE(a, b) compareSortField((a)->ResolutionCode, (b)->ResolutionCode)
+#define SORT_FIELD_COMPARE_REPORTING_EMPLOYEE_ID(a, b) compareSortField((a)->ReportingEmployeeId, (b)->ReportingEmployeeId)
+
+// Field of a set of loose field values
+#define SORT_FIELD_VALUE_LINE_CODE(fields) ((fields)->LineCode)
+#define SORT_FIELD_VALUE_BATCH_CODE(fields) ((fields)->BatchCode)
+#define SORT_FIELD_VALUE_BATCH_DATE_TIME(fields) ((fields)->BatchDateTime)
+#define SORT_FIELD_VALUE_PRODUCT_ID(fields) ((fields)->ProductId)
+#define SORT_FIELD_VALUE_ISSUE_CODE(fields) ((fields)->IssueCode)
+#define SORT_FIELD_VALUE_RESOLUTION_CODE(fields) ((fields)->ResolutionCode)
+#define SORT_FIELD_VALUE_REPORTING_EMPLOYEE_ID(fields) ((fields)->ReportingEmployeeId)
+
+// Setting a field of a ProductionLine_Log record from its int value
+#define SORT_FIELD_SET_LINE_CODE(log, value) ((log)->LineCode = (value))
+#define SORT_FIELD_SET_BATCH_CODE(log, value) ((log)->BatchCode = (value))
+#define SORT_FIELD_SET_BATCH_DATE_TIME(log, value) ((log)->BatchDateTime = unpackDateTime((uint16_t)(value)))
+#define SORT_FIELD_SET_PRODUCT_ID(log, value) ((log)->ProductId = (value))
+#define SORT_FIELD_SET_ISSUE_CODE(log, value) ((log)->IssueCode = (value))
+#define SORT_FIELD_SET_RESOLUTION_CODE(log, value) ((log)->ResolutionCode = (value))
+#define SORT_FIELD_SET_REPORTING_EMPLOYEE_ID(log, value) ((log)->ReportingEmployeeId = (value))
+
+// Define loose values of the sortable fields of a log, named as in ProductionLine_Log; fields an order does not list
+// are ignored, so a search key names only the fields it fixes
+struct SortKeyFields
+{
+    int LineCode;
+    int BatchCode;
+    int BatchDateTime; // Packed, as in the store
+    int ProductId;
+    int IssueCode;
+    int ResolutionCode;
+    int ReportingEmployeeId;
+};
+
+
+// Function to compare two field values: -1, 0 or 1
+static inline int compareSortField(int a, int b)
+{
+    return (a > b) - (a < b);
+}
+
+
+// Function to compare two dates and times field by field, as the original report comparison did
+static inline int compareSortDateTimes(const struct DateTime *a, const struct DateTime *b)
+{
+    int order = compareSortField(a->dayofmonth, b->dayofmonth);
+    order = order != 0 ? order : compareSortField(a->hourofday, b->hourofday);
+    return order != 0 ? order : compareSortField(a->minuteofhour, b->minuteofhour);
+}
+
+
+// Function to turn a field value into its bits of a packed key
+static inline uint64_t packSortField(int value, int bits)
+{
+    return bits == 32 ? (uint64_t)((uint32_t)value ^ 0x80000000u) : (uint64_t)(uint32_t)value;
+}
+
+
+// Function to turn the bits of a packed key back into a field value
+static inline int unpackSortField(uint64_t field, int bits)
+{
+    return bits == 32 ? (int)((uint32_t)field ^ 0x80000000u) : (int)field;
+}
+
+
+// Function to check whether a field value fits into its bits of a packed key
+static inline int fitsSortField(int value, int bits)
+{
+    return bits == 32 || (value >= 0 && (uint32_t)value < (1u << bits));
+}
+
+
+// Expansions of one FIELD(name, bits) of an order list
+#define SORT_KEY_BITS(field, bits) + (bits)
+#define SORT_KEY_CHECK(field, bits) _Static_assert((bits) >= 1 && (bits) <= 32, #field " must take 1 to 32 bits of a sort key");
+#define SORT_KEY_FITS(field, bits) && fitsSortField(SORT_FIELD_STORE_##field(store, row), (bits))
+#define SORT_KEY_PACK(field, bits) key = (key << (bits)) | packSortField(SORT_FIELD_STORE_##field(store, row), (bits));
+#define SORT_KEY_FITS_VALUE(field, bits) && fitsSortField(SORT_FIELD_VALUE_##field(fields), (bits))
+#define SORT_KEY_PACK_VALUE(field, bits) key = (key << (bits)) | packSortField(SORT_FIELD_VALUE_##field(fields), (bits));
+#define SORT_KEY_UNPACK(field, bits) \
+    remaining -= (bits); \
+    SORT_FIELD_SET_##field(log, unpackSortField((key >> remaining) & ((1ULL << (bits)) - 1), (bits)));
+#define SORT_KEY_COMPARE(field, bits) order = order != 0 ? order : SORT_FIELD_COMPARE_##field(a, b);
+#define SORT_KEY_COMPARE_ROWS(field, bits) \
+    order = order != 0 ? order : compareSortField(SORT_FIELD_STORE_##field(store, a), SORT_FIELD_STORE_##field(store, b));
+
+// Generate the key, fit check, unpacking and comparison functions of the report order listed by ORDER
+#define DEFINE_SORT_KEY(name, ORDER) \
+    _Static_assert((0 ORDER(SORT_KEY_BITS)) <= 64, #name " needs more than the 64 bits of a sort key"); \
+    ORDER(SORT_KEY_CHECK) \
+    static inline int name##Fits(const struct LogStore *store, int row) \
+    { \
+        (void)store; \
+        (void)row; \
+        return 1 ORDER(SORT_KEY_FITS); \
+    } \
+    static inline uint64_t name##Key(const struct LogStore *store, int row) \
+    { \
+        uint64_t key = 0; \
+        ORDER(SORT_KEY_PACK) \
+        return key; \
+    } \
+    static inline int name##FitsFields(const struct SortKeyFields *fields) \
+    { \
+        (void)fields; \
+        return 1 ORDER(SORT_KEY_FITS_VALUE); \
+    } \
+    static inline uint64_t name##KeyOf(const struct SortKeyFields *fields) \
+    { \
+        uint64_t key = 0; \
+        ORDER(SORT_KEY_PACK_VALUE) \
+        return key; \
+    } \
+    static inline void name##Unpack(uint64_t key, struct ProductionLine_Log *log) \
+    { \
+        int remaining = 0 ORDER(SORT_KEY_BITS); \
+        ORDER(SORT_KEY_UNPACK) \
+    } \
+    static inline int name##Compare(const struct ProductionLine_Log *a, const struct ProductionLine_Log *b) \
+    { \
+        int order = 0; \
+        ORDER(SORT_KEY_COMPARE) \
+        return order; \
+    } \
+    static inline int name##CompareRows(const struct LogStore *store, int a, int b) \
+    { \
+        int order = 0; \
+        ORDER(SORT_KEY_COMPARE_ROWS) \
+        return order; \
+    }
+
+
+// Packed log key: Product ID (24 bits) | Issue Code (24 bits) | packed Batch Date & Time (16 bits)
+// Comparing two packed keys gives the same order as comparing Product ID, Issue Code, day, hour and minute one by one.
+// Batch Date & Time stays the lowest field, so key >> LOG_KEY_DATE_TIME_BITS is the (Product ID, Issue Code) prefix
+#define LOG_KEY_ID_BITS 24
+#define LOG_KEY_DATE_TIME_BITS 16
+#define LOG_KEY_FIELD_LIMIT (1 << LOG_KEY_ID_BITS)
+
+// Report order of task 1, and the order of the search, archive and index files
+#define PRODUCT_ISSUE_ORDER(FIELD) \
+    FIELD(PRODUCT_ID, LOG_KEY_ID_BITS) FIELD(ISSUE_CODE, LOG_KEY_ID_BITS) FIELD(BATCH_DATE_TIME, LOG_KEY_DATE_TIME_BITS)
+DEFINE_SORT_KEY(productIssueOrder, PRODUCT_ISSUE_ORDER)
+
+
+// Function to check that Product ID and Issue Code fit into a packed log key
+static inline int fitsLogKey(int productID, int issueCode)
+{
+    struct SortKeyFields fields = {0};
+    fields.ProductId = productID;
+    fields.IssueCode = issueCode;
+    return productIssueOrderFitsFields(&fields);
+}
+
+
+// Function to pack Product ID, Issue Code and a packed Batch Date & Time into one 64-bit key
+static inline uint64_t packLogKey(int productID, int issueCode, int packed_date_time)
+{
+    struct SortKeyFields fields = {0};
+    fields.ProductId = productID;
+    fields.IssueCode = issueCode;
+    fields.BatchDateTime = packed_date_time;
+    return productIssueOrderKeyOf(&fields);
+}
+
+
+// Define a compact sort entry holding the packed log key of a log and its row in the log store
+struct SortEntry
+{
+    uint64_t key;
+    int index;
+};
+
+// The radix sort processes the 64-bit key as four 16-bit digits, least significant first
+#define RADIX_DIGIT_BITS 16
+#define RADIX_BUCKETS (1 << RADIX_DIGIT_BITS)
+#define RADIX_PASSES (64 / RADIX_DIGIT_BITS)
+
+// Below this many entries the bucket offsets cost more than a comparison sort
+#define RADIX_MIN_SIZE (1 << 14)
+
+
+// Function to build the (packed key, row) entries for rows start to end - 1 of the store into entries[0..end-start-1]
+// Only the Product ID, Issue Code and Batch Date & Time columns are read
+// Returns 0 if a log has a Product ID or Issue Code outside the packed key range
+static inline int buildSortEntries(const struct LogStore *store, int start, int end, struct SortEntry entries[])
+{
+    for (int row = start; row < end; row++)
+    {
+        if (!productIssueOrderFits(store, row))
+        {
+            return 0;
+        }
+        entries[row - start].key = productIssueOrderKey(store, row);
+        entries[row - start].index = row;
+    }
+    return 1;
+}
+
+
+// Merge entries[left..mid-1] and entries[mid..right-1] into output[left..right-1]
+// Equal keys are taken from the left run first so the sort stays stable
+static inline void mergeEntries(const struct SortEntry entries[], struct SortEntry output[], int left, int mid, int right)
+{
+    int i = left;
+    int j = mid;
+    int k = left;
+
+    while (i < mid && j < right)
+    {
+        if (entries[j].key < entries[i].key)
+        {
+            output[k++] = entries[j++];
+        }
+        else
+        {
+            output[k++] = entries[i++];
+        }
+    }
+    TRACE_COUNT(TRACE_COMPARISONS, k - left);
+    TRACE_COUNT(TRACE_MOVES, right - left);
+    while (i < mid)
+    {
+        output[k++] = entries[i++];
+    }
+    while (j < right)
+    {
+        output[k++] = entries[j++];
+    }
+}
+
+
+// Bottom-up merge sort of entries[], using scratch[] as the second buffer
+// Returns whichever of the two buffers holds the sorted entries
+static inline struct SortEntry *sortEntries(struct SortEntry entries[], struct SortEntry scratch[], int size)
+{
+    struct SortEntry *source = entries;
+    struct SortEntry *target = scratch;
+
+    for (int width = 1; width < size; width *= 2)
+    {
+        for (int left = 0; left < size; left += 2 * width)
+        {
+            int mid = left + width < size ? left + width : size;
+            int right = left + 2 * width < size ? left + 2 * width : size;
+            mergeEntries(source, target, left, mid, right);
+        }
+
+        // The merged runs become the input of the next pass
+        struct SortEntry *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    return source;
+}
+
+
+// Stable LSD radix sort of entries[], using scratch[] as the second buffer
+// All digit histograms are counted in one pass, and passes where every key has the same digit are skipped
+// Returns whichever of the two buffers holds the sorted entries, or NULL if the histograms could not be allocated
+static inline struct SortEntry *radixSortEntries(struct SortEntry entries[], struct SortEntry scratch[], int size)
+{
+    if (size < RADIX_MIN_SIZE)
+    {
+        return sortEntries(entries, scratch, size);
+    }
+
+    int *counts = (int *)calloc((size_t)RADIX_PASSES * RADIX_BUCKETS, sizeof(int));
+    if (counts == NULL)
+    {
+        return NULL;
+    }
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+
+    // Count the occurrences of every digit value for all passes at once
+    for (int i = 0; i < size; i++)
+    {
+        uint64_t key = entries[i].key;
+        for (int pass = 0; pass < RADIX_PASSES; pass++)
+        {
+            counts[pass * RADIX_BUCKETS + (int)((key >> (pass * RADIX_DIGIT_BITS)) & (RADIX_BUCKETS - 1))]++;
+        }
+    }
+
+    struct SortEntry *source = entries;
+    struct SortEntry *target = scratch;
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        int *pass_counts = counts + pass * RADIX_BUCKETS;
+        int shift = pass * RADIX_DIGIT_BITS;
+
+        // Skip the pass if all keys share the same digit, it would not change the order
+        if (pass_counts[(source[0].key >> shift) & (RADIX_BUCKETS - 1)] == size)
+        {
+            continue;
+        }
+
+        // Turn the digit counts into starting offsets
+        int offset = 0;
+        for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++)
+        {
+            int count = pass_counts[bucket];
+            pass_counts[bucket] = offset;
+            offset += count;
+        }
+
+        // Scatter the entries in their current order, which keeps the sort stable
+        for (int i = 0; i < size; i++)
+        {
+            int bucket = (int)((source[i].key >> shift) & (RADIX_BUCKETS - 1));
+            target[pass_counts[bucket]++] = source[i];
+        }
+        TRACE_COUNT(TRACE_MOVES, size);
+
+        struct SortEntry *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    free(counts);
+    return source;
+}
+
+
+// Function to sort (key, index) entries by key, equal keys keeping their order, with the radix sort
+// Returns 0 if memory could not be allocated, in which case the entries are unchanged
+static inline int sortKeyEntries(struct SortEntry entries[], int size)
+{
+    struct SortEntry *scratch = (struct SortEntry *)malloc((size_t)(size > 0 ? size : 1) * sizeof(struct SortEntry));
+    if (scratch == NULL)
+    {
+        return 0;
+    }
+
+    struct SortEntry *sorted = radixSortEntries(entries, scratch, size);
+    if (sorted == scratch)
+    {
+        memcpy(entries, scratch, (size_t)size * sizeof(struct SortEntry));
+    }
+    free(scratch);
+    return sorted != NULL;
+}
+
+
+// Function to build the (packed log key, row) entries of every log of the store, sorted by key and then by row, in O(N)
+// This is the order of task 1's report and of the search, archive and index files; action says what the entries are
+// for ("indexed", "archived") in the message printed when a log does not fit
+// Returns the entries, to be freed by the caller, or NULL after printing the reason if a log does not fit into a
+// packed key or memory could not be allocated
+static inline struct SortEntry *sortLogKeyEntries(const struct LogStore *store, const char *action)
+{
+    int size = store->size;
+    struct SortEntry *entries = (struct SortEntry *)malloc((size_t)(size > 0 ? size : 1) * sizeof(struct SortEntry));
+    if (entries == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+
+    if (!buildSortEntries(store, 0, size, entries))
+    {
+        int row = 0;
+        while (productIssueOrderFits(store, row))
+        {
+            row++;
+        }
+        printf("Log %d cannot be %s: Product ID or Issue Code out of range.\n", row, action);
+        free(entries);
+        return NULL;
+    }
+    if (!sortKeyEntries(entries, size))
+    {
+        printf("Memory allocation failed.\n");
+        free(entries);
+        return NULL;
+    }
+    return entries;
+}
+
+#endif
@@ -0,0 +1,289 @@
+/*
+Per-product time index over the shared log store.
+
+Answers "issues for product P (on line L) between two dates and times" without scanning the month. The logs are
+indexed once by (Product ID, Batch Date & Time):
+
+    entries[]         - (Product ID << 16 | packed Batch Date & Time, row) pairs in ascending order
+    line_prefix[]     - for every production line, the number of its logs among the first i entries
+    line_positions[]  - for every production line, the positions in entries[] of its logs, in index order
+
+The logs of a product within a time range are one contiguous block of entries[], found by two binary searches in
+O(log N). A count is the size of that block, or the difference of two prefix counts when filtered by line, so counts
+never scan. A listing visits only the k matching logs: the block itself, or the slice of the line's positions between
+the two prefix counts, in O(log N + k).
+
+The prefix counts take (L + 1) ints per log for L production lines, so at most TIME_INDEX_MAX_LINES distinct Line
+Codes are indexed.
+*/
+
+#ifndef QA_TIME_INDEX_H
+#define QA_TIME_INDEX_H
+
+#include "qa_log_store.h"
+#include "qa_sort_key.h"
+
+#define TIME_INDEX_MAX_LINES 32
+
+// Order of the time index: Product ID, then Batch Date & Time, with the widths of the packed log key
+#define PRODUCT_TIME_ORDER(FIELD) FIELD(PRODUCT_ID, LOG_KEY_ID_BITS) FIELD(BATCH_DATE_TIME, LOG_KEY_DATE_TIME_BITS)
+DEFINE_SORT_KEY(productTimeOrder, PRODUCT_TIME_ORDER)
+
+// Define the per-product time index
+struct TimeIndex
+{
+    struct SortEntry *entries;
+    int size;
+    int line_count;
+    int32_t line_codes[TIME_INDEX_MAX_LINES];
+    int line_start[TIME_INDEX_MAX_LINES + 1]; // Start of each line's positions in line_positions
+    int *line_prefix;                         // line_prefix[l * (size + 1) + i]: logs of line l among entries 0 to i - 1
+    int *line_positions;
+};
+
+// Define the matches of a time range query, visited one at a time
+struct TimeRangeCursor
+{
+    const struct TimeIndex *index;
+    const int *positions; // Positions of the line's logs, or NULL when not filtered by line
+    int next;
+    int end;
+};
+
+
+// Function to check that a Product ID fits into a time index key
+static inline int fitsTimeKey(int productID)
+{
+    struct SortKeyFields fields = {0};
+    fields.ProductId = productID;
+    return productTimeOrderFitsFields(&fields);
+}
+
+
+// Function to pack a Product ID and a packed Batch Date & Time into a time index key
+static inline uint64_t packTimeKey(int productID, int packed_date_time)
+{
+    struct SortKeyFields fields = {0};
+    fields.ProductId = productID;
+    fields.BatchDateTime = packed_date_time;
+    return productTimeOrderKeyOf(&fields);
+}
+
+
+// Function to find the number of a Line Code in the index, or -1 if no log of the index is on that line
+static inline int findTimeIndexLine(const struct TimeIndex *index, int lineCode)
+{
+    for (int l = 0; l < index->line_count; l++)
+    {
+        if (index->line_codes[l] == lineCode)
+        {
+            return l;
+        }
+    }
+    return -1;
+}
+
+
+// Function to release a time index
+static inline void freeTimeIndex(struct TimeIndex *index)
+{
+    free(index->entries);
+    free(index->line_prefix);
+    free(index->line_positions);
+    memset(index, 0, sizeof(struct TimeIndex));
+}
+
+
+// Function to build the time index over the log store in O(N)
+// Only the Product ID, Line Code and Batch Date & Time columns are read
+// Returns 0 if memory could not be allocated, a Product ID does not fit into a key or there are too many lines
+static inline int buildTimeIndex(struct TimeIndex *index, const struct LogStore *store)
+{
+    int size = store->size;
+    memset(index, 0, sizeof(struct TimeIndex));
+    index->entries = (struct SortEntry *)malloc((size_t)(size > 0 ? size : 1) * sizeof(struct SortEntry));
+    if (index->entries == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        return 0;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        if (!productTimeOrderFits(store, i))
+        {
+            printf("Log %d cannot be indexed: Product ID out of range.\n", i);
+            freeTimeIndex(index);
+            return 0;
+        }
+        if (findTimeIndexLine(index, store->LineCode[i]) < 0)
+        {
+            if (index->line_count == TIME_INDEX_MAX_LINES)
+            {
+                printf("Cannot index logs of more than %d production lines.\n", TIME_INDEX_MAX_LINES);
+                freeTimeIndex(index);
+                return 0;
+            }
+            index->line_codes[index->line_count++] = store->LineCode[i];
+        }
+        index->entries[i].key = productTimeOrderKey(store, i);
+        index->entries[i].index = i;
+    }
+    if (!sortKeyEntries(index->entries, size))
+    {
+        printf("Memory allocation failed.\n");
+        freeTimeIndex(index);
+        return 0;
+    }
+    index->size = size;
+
+    index->line_prefix = (int *)malloc((size_t)(index->line_count > 0 ? index->line_count : 1) * ((size_t)size + 1) * sizeof(int));
+    index->line_positions = (int *)malloc((size_t)(size > 0 ? size : 1) * sizeof(int));
+    if (index->line_prefix == NULL || index->line_positions == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        freeTimeIndex(index);
+        return 0;
+    }
+
+    // Count the logs of every line before each position, which also sizes each line's list of positions
+    int line_counts[TIME_INDEX_MAX_LINES] = {0};
+    for (int i = 0; i <= size; i++)
+    {
+        for (int l = 0; l < index->line_count; l++)
+        {
+            index->line_prefix[(size_t)l * (size + 1) + i] = line_counts[l];
+        }
+        if (i < size)
+        {
+            line_counts[findTimeIndexLine(index, store->LineCode[index->entries[i].index])]++;
+        }
+    }
+
+    int start = 0;
+    for (int l = 0; l < index->line_count; l++)
+    {
+        index->line_start[l] = start;
+        start += line_counts[l];
+    }
+    index->line_start[index->line_count] = start;
+
+    int fill[TIME_INDEX_MAX_LINES];
+    memcpy(fill, index->line_start, sizeof(fill));
+    for (int i = 0; i < size; i++)
+    {
+        index->line_positions[fill[findTimeIndexLine(index, store->LineCode[index->entries[i].index])]++] = i;
+    }
+    return 1;
+}
+
+
+// Function to find the first entry of the index whose key is not less than key
+static inline int timeIndexLowerBound(const struct TimeIndex *index, uint64_t key)
+{
+    int left = 0;
+    int right = index->size;
+    while (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        if (index->entries[mid].key < key)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+
+// Function to open a query for the logs of productID from packed date and time from_date_time to to_date_time
+// (both included), on line lineCode or on every line when lineCode is -1, in O(log N)
+// Returns the number of matching logs; the cursor then visits them in date and time order
+static inline int openTimeRange(struct TimeRangeCursor *cursor, const struct TimeIndex *index, int productID, int lineCode,
+                                int from_date_time, int to_date_time)
+{
+    cursor->index = index;
+    cursor->positions = NULL;
+    cursor->next = 0;
+    cursor->end = 0;
+    if (!fitsTimeKey(productID) || from_date_time > to_date_time)
+    {
+        return 0;
+    }
+
+    int first = timeIndexLowerBound(index, packTimeKey(productID, from_date_time));
+    int last = timeIndexLowerBound(index, packTimeKey(productID, to_date_time) + 1);
+    if (lineCode == -1)
+    {
+        cursor->next = first;
+        cursor->end = last;
+        return last - first;
+    }
+
+    // The prefix counts at both ends give the slice of the line's positions that falls within the range
+    int line = findTimeIndexLine(index, lineCode);
+    if (line < 0)
+    {
+        return 0;
+    }
+    const int *prefix = index->line_prefix + (size_t)line * (index->size + 1);
+    cursor->positions = index->line_positions + index->line_start[line];
+    cursor->next = prefix[first];
+    cursor->end = prefix[last];
+    return cursor->end - cursor->next;
+}
+
+
+// Function to take the next log of a time range query
+// Returns its row in the log store, or -1 once all have been visited
+static inline int nextTimeRange(struct TimeRangeCursor *cursor)
+{
+    if (cursor->next == cursor->end)
+    {
+        return -1;
+    }
+    int position = cursor->positions != NULL ? cursor->positions[cursor->next] : cursor->next;
+    cursor->next++;
+    return cursor->index->entries[position].index;
+}
+
+
+// Function to count the logs of productID between two packed dates and times (both included), on line lineCode or
+// on every line when lineCode is -1, in O(log N) without visiting them
+static inline int countTimeRange(const struct TimeIndex *index, int productID, int lineCode, int from_date_time, int to_date_time)
+{
+    struct TimeRangeCursor cursor;
+    return openTimeRange(&cursor, index, productID, lineCode, from_date_time, to_date_time);
+}
+
+
+// Function to read "product from_day to_day [line]" arguments of a range query
+// Sets the Product ID, the packed first and last minute of the day range and the Line Code (-1 for all lines)
+// Returns 0, after printing why, if the arguments are not valid
+static inline int parseTimeRangeArguments(int count, char *arguments[], int *productID, int *from_date_time, int *to_date_time, int *lineCode)
+{
+    if (count < 3 || count > 4)
+    {
+        printf("A range query needs a Product ID, a first and last day, and optionally a Line Code.\n");
+        return 0;
+    }
+
+    struct DateTime from = {atoi(arguments[1]), 0, 0};
+    struct DateTime to = {atoi(arguments[2]), 23, 59};
+    if (from.dayofmonth < 1 || to.dayofmonth > 31 || from.dayofmonth > to.dayofmonth)
+    {
+        printf("Days must be from 1 to 31, the first not after the last.\n");
+        return 0;
+    }
+
+    *productID = atoi(arguments[0]);
+    *from_date_time = packDateTime(&from);
+    *to_date_time = packDateTime(&to);
+    *lineCode = count == 4 ? atoi(arguments[3]) : -1;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,224 @@
+/*
+Hot-path instrumentation for the task programs.
+
+Counts the work done by the sort, group, search and count kernels (key comparisons, record moves, allocations,
+list hops, search probes and scanned rows) and times the phases of a report run (loading, sorting or building,
+printing). It is compiled in only when QA_TRACE is defined:
+
+    gcc -DQA_TRACE -O2 -pthread task1_assignment.c
+
+Without QA_TRACE every TRACE_ macro expands to nothing, so the kernels are exactly the same as before.
+
+Kernels count into thread-local counters, which cost one increment and no synchronisation; worker threads add
+theirs to the shared totals with TRACE_FLUSH() before they exit. TRACE_DUMP() at the end of a run writes the
+totals and every phase, with its duration and the counts made during it, to stderr. When the QA_TRACE_FILE
+environment variable names a file, the phases are also written to it as Chrome trace JSON, which chrome://tracing
+and Perfetto open.
+*/
+
+#ifndef QA_TRACE_H
+#define QA_TRACE_H
+
+#include "qa_log_store.h"
+
+// Define the counters kept by the instrumented kernels
+enum TraceCounter
+{
+    TRACE_COMPARISONS, // Key comparisons of the sorts
+    TRACE_MOVES,       // Records or sort entries copied
+    TRACE_ALLOCATIONS, // Heap or stack buffers allocated by the kernels
+    TRACE_LIST_HOPS,   // Linked list nodes walked
+    TRACE_PROBES,      // Binary search steps and hash table slots looked at
+    TRACE_SCANS,       // Rows read by linear scans
+    TRACE_COUNTER_COUNT
+};
+
+#ifdef QA_TRACE
+
+#include <stdatomic.h>
+
+// Most phases recorded in one run; later phases are not recorded
+#define TRACE_MAX_PHASES 256
+
+// Define a timed phase of a run and the counts made while it was open
+struct TracePhase
+{
+    const char *name;
+    double start_ms;
+    double duration_ms; // Negative while the phase is open
+    int depth;
+    uint64_t counts[TRACE_COUNTER_COUNT];
+};
+
+// Define the shared totals of all threads and the phases recorded by the main thread
+struct TraceState
+{
+    _Atomic uint64_t totals[TRACE_COUNTER_COUNT];
+    struct TracePhase phases[TRACE_MAX_PHASES];
+    int phase_count;
+    int depth;
+};
+
+static const char *const trace_counter_names[TRACE_COUNTER_COUNT] =
+{
+    "comparisons", "moves", "allocations", "list_hops", "probes", "scanned_rows"
+};
+
+static struct TraceState trace_state;
+static _Thread_local uint64_t trace_local[TRACE_COUNTER_COUNT];
+
+#define TRACE_COUNT(counter, amount) (trace_local[counter] += (uint64_t)(amount))
+#define TRACE_FLUSH() traceFlush()
+#define TRACE_BEGIN(phase) int trace_phase_##phase = traceBegin(#phase)
+#define TRACE_END(phase) traceEnd(trace_phase_##phase)
+#define TRACE_DUMP() traceDump()
+
+
+// Function to add the counts of the calling thread to the shared totals
+static inline void traceFlush(void)
+{
+    for (int c = 0; c < TRACE_COUNTER_COUNT; c++)
+    {
+        if (trace_local[c] != 0)
+        {
+            atomic_fetch_add_explicit(&trace_state.totals[c], trace_local[c], memory_order_relaxed);
+            trace_local[c] = 0;
+        }
+    }
+}
+
+
+// Function to read the totals, including the counts of the calling thread
+static inline void traceTotals(uint64_t totals[])
+{
+    traceFlush();
+    for (int c = 0; c < TRACE_COUNTER_COUNT; c++)
+    {
+        totals[c] = atomic_load_explicit(&trace_state.totals[c], memory_order_relaxed);
+    }
+}
+
+
+// Function to open a phase named name on the main thread
+// Returns the phase number to close it with, or -1 if too many phases were recorded
+static inline int traceBegin(const char *name)
+{
+    if (trace_state.phase_count == TRACE_MAX_PHASES)
+    {
+        return -1;
+    }
+
+    struct TracePhase *phase = &trace_state.phases[trace_state.phase_count];
+    phase->name = name;
+    phase->depth = trace_state.depth++;
+    phase->duration_ms = -1.0;
+    traceTotals(phase->counts);
+    phase->start_ms = currentTimeMs();
+    return trace_state.phase_count++;
+}
+
+
+// Function to close phase number phase_number, keeping the counts made since it was opened
+static inline void traceEnd(int phase_number)
+{
+    if (phase_number < 0)
+    {
+        return;
+    }
+
+    struct TracePhase *phase = &trace_state.phases[phase_number];
+    phase->duration_ms = currentTimeMs() - phase->start_ms;
+
+    uint64_t totals[TRACE_COUNTER_COUNT];
+    traceTotals(totals);
+    for (int c = 0; c < TRACE_COUNTER_COUNT; c++)
+    {
+        phase->counts[c] = totals[c] - phase->counts[c];
+    }
+    trace_state.depth = phase->depth;
+}
+
+
+// Function to write the recorded phases to path as Chrome trace JSON, times in microseconds from the first phase
+// Returns 0 if the file could not be written
+static inline int writeTraceFile(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    double origin_ms = trace_state.phase_count > 0 ? trace_state.phases[0].start_ms : 0.0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    int written = 0;
+    for (int p = 0; p < trace_state.phase_count; p++)
+    {
+        const struct TracePhase *phase = &trace_state.phases[p];
+        if (phase->duration_ms < 0)
+        {
+            continue;
+        }
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                written++ > 0 ? "," : "", phase->name, (phase->start_ms - origin_ms) * 1000.0, phase->duration_ms * 1000.0);
+        for (int c = 0; c < TRACE_COUNTER_COUNT; c++)
+        {
+            fprintf(file, "%s\"%s\":%llu", c > 0 ? "," : "", trace_counter_names[c], (unsigned long long)phase->counts[c]);
+        }
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
+
+
+// Function to write the counter totals and the phases of the run to stderr, and the Chrome trace if requested
+static inline void traceDump(void)
+{
+    uint64_t totals[TRACE_COUNTER_COUNT];
+    traceTotals(totals);
+
+    fprintf(stderr, "Trace counters:");
+    for (int c = 0; c < TRACE_COUNTER_COUNT; c++)
+    {
+        fprintf(stderr, " %s=%llu", trace_counter_names[c], (unsigned long long)totals[c]);
+    }
+    fprintf(stderr, "\n");
+
+    for (int p = 0; p < trace_state.phase_count; p++)
+    {
+        const struct TracePhase *phase = &trace_state.phases[p];
+        if (phase->duration_ms < 0)
+        {
+            continue;
+        }
+        fprintf(stderr, "Trace phase %*s%-12s %10.3f ms", 2 * phase->depth, "", phase->name, phase->duration_ms);
+        for (int c = 0; c < TRACE_COUNTER_COUNT; c++)
+        {
+            if (phase->counts[c] != 0)
+            {
+                fprintf(stderr, " %s=%llu", trace_counter_names[c], (unsigned long long)phase->counts[c]);
+            }
+        }
+        fprintf(stderr, "\n");
+    }
+
+    const char *path = getenv("QA_TRACE_FILE");
+    if (path != NULL && *path != '\0' && !writeTraceFile(path))
+    {
+        fprintf(stderr, "Could not write trace file %s.\n", path);
+    }
+}
+
+#else
+
+#define TRACE_COUNT(counter, amount) ((void)0)
+#define TRACE_FLUSH() ((void)0)
+#define TRACE_BEGIN(phase) ((void)0)
+#define TRACE_END(phase) ((void)0)
+#define TRACE_DUMP() ((void)0)
+
+#endif
+
+#endif
@@ -28,100 +28,104 @@ Beatrice Maria Giurgica
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_log_csv.h"
+#include "qa_trace.h"
+#include "qa_report.h"
+#include "qa_sort_key.h"
 
-// Define DateTime structure
-struct DateTime
-{      
-    int dayofmonth;
-    int hourofday;
-    int minuteofhour;
-};
+// The adaptive sort extends natural runs shorter than this by insertion, and sorts input whose natural runs are
+// shorter than ADAPTIVE_MIN_AVERAGE_RUN on average with the radix sort instead
+#define ADAPTIVE_MIN_RUN 32
+#define ADAPTIVE_MIN_AVERAGE_RUN 64
 
-// Define ProductionLine_Log structure
-struct ProductionLine_Log 
-{
-    int LineCode;
-    int BatchCode;
-    struct DateTime BatchDateTime;
-    int ProductId;
-    int IssueCode;
-    char IssueDescription[100];
-    int ResolutionCode;
-    char ResolutionDescription[100];
-    int ReportingEmployeeId;
-};
+// Pending runs of the adaptive sort: their lengths grow like the Fibonacci numbers, so 2^31 entries need fewer than 48
+#define ADAPTIVE_MAX_PENDING_RUNS 48
+
+// The parallel sort splits the log into this many chunks per thread so that idle threads have work to steal
+#define PARALLEL_CHUNKS_PER_THREAD 4
+
+// Entries sampled from every sorted chunk to choose the splitters of the parallel merge
+#define PARALLEL_SAMPLES_PER_CHUNK 64
+
+// Below this many logs the parallel sort runs the serial index sort instead
+#define PARALLEL_MIN_SIZE (1 << 16)
+
+// The external sort uses this budget in megabytes when none is given, and never makes runs or read buffers smaller
+// than these many entries
+#define EXTERNAL_DEFAULT_BUDGET_MB 64
+#define EXTERNAL_MIN_RUN (1 << 12)
+#define EXTERNAL_MIN_READ (1 << 8)
+
+// A live order has at most log2(N) + 1 levels, N being below 2^31
+#define LIVE_ORDER_MAX_LEVELS 33
+
+// Signature shared by the engines that sort (key, index) entries
+typedef struct SortEntry *(*EntrySortFunction)(struct SortEntry entries[], struct SortEntry scratch[], int size);
 
 
 // Merge two subarrays of logs_data[]
 // First subarray goes from left to mid
 // Second subarray goes from mid+1 to right
-void merge(struct ProductionLine_Log logs_data[], int left, int mid, int right) 
+// Both are copied into temp[left..right] first, temp[] being the scratch buffer allocated once by mergeSort()
+void merge(struct ProductionLine_Log logs_data[], struct ProductionLine_Log temp[], int left, int mid, int right) 
 {
     int i, j, k;
-    int left_size = mid - left + 1;
-    int right_size = right - mid;
 
-    // Create temporary arrays
-    struct ProductionLine_Log temp_left[left_size], temp_right[right_size];
-
-    // Copy data to temporary arrays temp_left[] and temp_right[]
-    for (i = 0; i < left_size; i++)
-    {
-        temp_left[i] = logs_data[left + i];
-    }
-    for (j = 0; j < right_size; j++)
+    // Copy data to the scratch buffer
+    for (i = left; i <= right; i++)
     {
-        temp_right[j] = logs_data[mid + 1 + j];
+        temp[i] = logs_data[i];
     }
 
-    // Merge the temporary arrays back into logs_data[]
-    i = 0; //initial index of first subarray
-    j = 0; //initial index of second subarray
+    // Merge the two halves of the scratch buffer back into logs_data[]
+    i = left; //initial index of first subarray
+    j = mid + 1; //initial index of second subarray
     k = left; //initial index of merged subarray
-    while (i < left_size && j < right_size) 
+    while (i <= mid && j <= right) 
     {
         // Compare based on hierarchical order of sorting criteria: Product ID, Issue Code and Batch Date & Time
-        if (temp_left[i].ProductId < temp_right[j].ProductId || 
-            (temp_left[i].ProductId == temp_right[j].ProductId && temp_left[i].IssueCode < temp_right[j].IssueCode) ||
-            (temp_left[i].ProductId == temp_right[j].ProductId && temp_left[i].IssueCode == temp_right[j].IssueCode && 
-            (temp_left[i].BatchDateTime.dayofmonth < temp_right[j].BatchDateTime.dayofmonth ||
-            (temp_left[i].BatchDateTime.dayofmonth == temp_right[j].BatchDateTime.dayofmonth &&
-            (temp_left[i].BatchDateTime.hourofday < temp_right[j].BatchDateTime.hourofday ||
-            (temp_left[i].BatchDateTime.hourofday == temp_right[j].BatchDateTime.hourofday &&
-            temp_left[i].BatchDateTime.minuteofhour < temp_right[j].BatchDateTime.minuteofhour))))))
-        {
-            logs_data[k] = temp_left[i];
+        if (productIssueOrderCompare(&temp[i], &temp[j]) < 0)
+        {
+            logs_data[k] = temp[i];
             i++;
         }
         else 
         {
-            logs_data[k] = temp_right[j];
+            logs_data[k] = temp[j];
             j++;
         }
         k++;
     }
+    TRACE_COUNT(TRACE_COMPARISONS, k - left);
 
-    // Copy the remaining elements of temp_left[], if there are any
-    while (i < left_size) 
+    // Copy the remaining elements of the first subarray, if there are any
+    while (i <= mid) 
     {
-        logs_data[k] = temp_left[i];
+        logs_data[k] = temp[i];
         i++;
         k++;
     }
 
-    // Copy the remaining elements of temp_right[], if there are any
-    while (j < right_size) 
+    // Copy the remaining elements of the second subarray, if there are any
+    while (j <= right) 
     {
-        logs_data[k] = temp_right[j];
+        logs_data[k] = temp[j];
         j++;
         k++;
     }
+    TRACE_COUNT(TRACE_MOVES, 2 * (right - left + 1));
 }
 
 
-// Merge Sort function to sort logs_data[] based on Product ID, Issue Code and Batch Date & Time
-void mergeSort(struct ProductionLine_Log logs_data[], int left, int right) 
+// Recursive part of mergeSort(), sorting logs_data[left..right] through the scratch buffer temp[]
+void mergeSortRange(struct ProductionLine_Log logs_data[], struct ProductionLine_Log temp[], int left, int right) 
 {
     if (left < right) 
     {
@@ -129,74 +133,1316 @@ void mergeSort(struct ProductionLine_Log logs_data[], int left, int right)
         int mid = left + (right - left) / 2;
 
         // Sort left and right halves
-        mergeSort(logs_data, left, mid);
-        mergeSort(logs_data, mid + 1, right);
+        mergeSortRange(logs_data, temp, left, mid);
+        mergeSortRange(logs_data, temp, mid + 1, right);
 
         // Merge sorted halves
-        merge(logs_data, left, mid, right);
+        merge(logs_data, temp, left, mid, right);
+    }
+}
+
+
+// Merge Sort function to sort logs_data[] based on Product ID, Issue Code and Batch Date & Time
+// The merges share one heap scratch buffer, so a full month of logs does not overflow the stack
+// Returns 0 if the scratch buffer could not be allocated, in which case logs_data[] is unchanged
+int mergeSort(struct ProductionLine_Log logs_data[], int left, int right) 
+{
+    if (left >= right)
+    {
+        return 1;
+    }
+
+    struct ProductionLine_Log *temp = (struct ProductionLine_Log *)malloc((size_t)(right - left + 1) * sizeof(struct ProductionLine_Log));
+    if (temp == NULL)
+    {
+        return 0;
+    }
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+
+    mergeSortRange(logs_data + left, temp, 0, right - left);
+    free(temp);
+    return 1;
+}
+
+
+// Function to count the natural non-decreasing runs of entries[]
+int countEntryRuns(const struct SortEntry entries[], int size)
+{
+    int runs = 1;
+    for (int i = 1; i < size; i++)
+    {
+        runs += entries[i].key < entries[i - 1].key;
+    }
+    TRACE_COUNT(TRACE_COMPARISONS, size - 1);
+    return runs;
+}
+
+
+// Function to find the natural run starting at entries[start]: a non-decreasing run, or a strictly decreasing run
+// which is reversed in place (it has no equal keys, so reversing it keeps the sort stable)
+// Returns the end of the run
+int findEntryRun(struct SortEntry entries[], int start, int size)
+{
+    int end = start + 1;
+    if (end == size)
+    {
+        return end;
+    }
+
+    if (entries[end].key < entries[start].key)
+    {
+        while (end + 1 < size && entries[end + 1].key < entries[end].key)
+        {
+            end++;
+        }
+        end++;
+        for (int i = start, j = end - 1; i < j; i++, j--)
+        {
+            struct SortEntry swap = entries[i];
+            entries[i] = entries[j];
+            entries[j] = swap;
+        }
+    }
+    else
+    {
+        while (end + 1 < size && entries[end + 1].key >= entries[end].key)
+        {
+            end++;
+        }
+        end++;
+    }
+    TRACE_COUNT(TRACE_COMPARISONS, end - start);
+    return end;
+}
+
+
+// Function to extend the sorted entries[start..sorted_end-1] to entries[start..end-1] by insertion
+void insertionSortEntries(struct SortEntry entries[], int start, int sorted_end, int end)
+{
+    for (int i = sorted_end; i < end; i++)
+    {
+        struct SortEntry entry = entries[i];
+        int j = i;
+        while (j > start && entry.key < entries[j - 1].key)
+        {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+        TRACE_COUNT(TRACE_COMPARISONS, i - j + (j > start));
+        TRACE_COUNT(TRACE_MOVES, i - j + 1);
+    }
+}
+
+
+// Function to find the first of entries[left..right-1] whose key is greater than key (or not less, if inclusive)
+int entryKeyBound(const struct SortEntry entries[], int left, int right, uint64_t key, int inclusive)
+{
+    while (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        TRACE_COUNT(TRACE_PROBES, 1);
+        if (entries[mid].key < key || (!inclusive && entries[mid].key == key))
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+
+// Function to merge the adjacent sorted runs entries[a..b-1] and entries[b..c-1] in place, through scratch[]
+// Entries of the left run already below the right run, and of the right run already above the left run, stay
+// where they are, so runs that are already in order cost a single comparison
+void mergeAdjacentRuns(struct SortEntry entries[], struct SortEntry scratch[], int a, int b, int c)
+{
+    TRACE_COUNT(TRACE_COMPARISONS, 1);
+    if (entries[b - 1].key <= entries[b].key)
+    {
+        return;
+    }
+    a = entryKeyBound(entries, a, b, entries[b].key, 0);
+    c = entryKeyBound(entries, b, c, entries[b - 1].key, 1);
+
+    int left_size = b - a;
+    memcpy(scratch, entries + a, (size_t)left_size * sizeof(struct SortEntry));
+
+    // Equal keys are taken from the left run first so the sort stays stable
+    int i = 0;
+    int j = b;
+    int k = a;
+    while (i < left_size && j < c)
+    {
+        entries[k++] = entries[j].key < scratch[i].key ? entries[j++] : scratch[i++];
+    }
+    TRACE_COUNT(TRACE_COMPARISONS, k - a);
+    TRACE_COUNT(TRACE_MOVES, left_size + c - a);
+    memcpy(entries + k, scratch + i, (size_t)(left_size - i) * sizeof(struct SortEntry));
+}
+
+
+// Adaptive natural merge sort of entries[] in the style of TimSort, using scratch[] for merges
+// Existing runs are detected and only merged with each other: runs shorter than ADAPTIVE_MIN_RUN are first extended
+// by insertion, and a stack of pending runs is merged whenever its run lengths stop decreasing fast enough, which
+// keeps the merges balanced. Sorted input takes one pass and input made of R runs takes O(N log R)
+// Input with fewer than ADAPTIVE_MIN_AVERAGE_RUN entries per natural run on average is handed to the radix sort
+// Returns whichever of the two buffers holds the sorted entries, or NULL if memory could not be allocated
+struct SortEntry *adaptiveSortEntries(struct SortEntry entries[], struct SortEntry scratch[], int size)
+{
+    int natural_runs = countEntryRuns(entries, size);
+    if (natural_runs == 1)
+    {
+        return entries;
+    }
+    if ((int64_t)natural_runs * ADAPTIVE_MIN_AVERAGE_RUN > size)
+    {
+        return radixSortEntries(entries, scratch, size);
+    }
+
+    // Run lengths on the stack grow at least like the Fibonacci numbers, so a small fixed stack is enough
+    int run_start[ADAPTIVE_MAX_PENDING_RUNS];
+    int run_size[ADAPTIVE_MAX_PENDING_RUNS];
+    int pending = 0;
+
+    for (int start = 0; start < size; )
+    {
+        int end = findEntryRun(entries, start, size);
+        if (end - start < ADAPTIVE_MIN_RUN)
+        {
+            int extended = start + ADAPTIVE_MIN_RUN < size ? start + ADAPTIVE_MIN_RUN : size;
+            insertionSortEntries(entries, start, end, extended);
+            end = extended;
+        }
+        run_start[pending] = start;
+        run_size[pending] = end - start;
+        pending++;
+        start = end;
+
+        // Merge until each run is longer than the two above it together and the one above it
+        while (pending > 1)
+        {
+            int k = pending - 2;
+            if ((k > 0 && run_size[k - 1] <= run_size[k] + run_size[k + 1]) ||
+                (k > 1 && run_size[k - 2] <= run_size[k - 1] + run_size[k]))
+            {
+                k -= run_size[k - 1] < run_size[k + 1];
+            }
+            else if (run_size[k] > run_size[k + 1])
+            {
+                break;
+            }
+            mergeAdjacentRuns(entries, scratch, run_start[k], run_start[k + 1], run_start[k + 1] + run_size[k + 1]);
+            run_size[k] += run_size[k + 1];
+            for (int r = k + 1; r < pending - 1; r++)
+            {
+                run_start[r] = run_start[r + 1];
+                run_size[r] = run_size[r + 1];
+            }
+            pending--;
+        }
+    }
+
+    // Merge whatever is left, smallest neighbours first
+    while (pending > 1)
+    {
+        int k = pending - 2;
+        k -= k > 0 && run_size[k - 1] < run_size[k + 1];
+        mergeAdjacentRuns(entries, scratch, run_start[k], run_start[k + 1], run_start[k + 1] + run_size[k + 1]);
+        run_size[k] += run_size[k + 1];
+        for (int r = k + 1; r < pending - 1; r++)
+        {
+            run_start[r] = run_start[r + 1];
+            run_size[r] = run_size[r + 1];
+        }
+        pending--;
+    }
+    return entries;
+}
+
+
+// Reorder the store so that row i holds the log at sorted[i].index
+// The row numbers are gathered into spare[], the half of the sort buffer not holding the result,
+// and every column of the store is then moved once
+int applySortOrder(struct LogStore *store, const struct SortEntry sorted[], struct SortEntry spare[])
+{
+    int *order = (int *)spare;
+    for (int i = 0; i < store->size; i++)
+    {
+        order[i] = sorted[i].index;
+    }
+    TRACE_COUNT(TRACE_MOVES, store->size);
+    return permuteLogStore(store, order);
+}
+
+
+// Index-based sort of the log store in Product ID, Issue Code and Batch Date & Time order
+// Only the 16-byte (key, index) entries are sorted by sort_entries, in one heap buffer, and the logs are then moved once
+// Returns 0 if the logs could not be sorted this way, in which case the store is left unchanged
+int indexSort(struct LogStore *store, EntrySortFunction sort_entries)
+{
+    int size = store->size;
+    if (size < 2)
+    {
+        return 1;
+    }
+
+    // One heap allocation holds both the entries and the merge scratch space
+    struct SortEntry *buffer = (struct SortEntry *)malloc(2 * (size_t)size * sizeof(struct SortEntry));
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+
+    if (!buildSortEntries(store, 0, size, buffer))
+    {
+        free(buffer);
+        return 0;
+    }
+
+    struct SortEntry *sorted = sort_entries(buffer, buffer + size, size);
+    int applied = sorted != NULL && applySortOrder(store, sorted, sorted == buffer ? buffer + size : buffer);
+
+    free(buffer);
+    return applied;
+}
+
+
+// Function to start the sorted report: its title, CSV header or binary header
+void beginSortedReport(struct ReportWriter *writer)
+{
+    if (writer->format == REPORT_CSV)
+    {
+        reportText(writer, "ProductId,IssueCode,Day,Hour,Minute\n");
+    }
+    else if (writer->format == REPORT_BINARY)
+    {
+        reportBinaryHeader(writer, 5);
+    }
+    else
+    {
+        reportText(writer, "Sorted Production Line Report:\n");
+    }
+}
+
+
+// Function to add one log to the sorted report
+void writeSortedLog(struct ReportWriter *writer, int productID, int issueCode, struct DateTime date_time)
+{
+    if (writer->format == REPORT_CSV)
+    {
+        reportInt(writer, productID);
+        reportChar(writer, ',');
+        reportInt(writer, issueCode);
+        reportChar(writer, ',');
+        reportInt(writer, date_time.dayofmonth);
+        reportChar(writer, ',');
+        reportInt(writer, date_time.hourofday);
+        reportChar(writer, ',');
+        reportInt(writer, date_time.minuteofhour);
+        reportChar(writer, '\n');
+    }
+    else if (writer->format == REPORT_BINARY)
+    {
+        reportInt32(writer, productID);
+        reportInt32(writer, issueCode);
+        reportInt32(writer, date_time.dayofmonth);
+        reportInt32(writer, date_time.hourofday);
+        reportInt32(writer, date_time.minuteofhour);
+    }
+    else
+    {
+        reportText(writer, "Product ID: ");
+        reportInt(writer, productID);
+        reportText(writer, "\nIssue Code: ");
+        reportInt(writer, issueCode);
+        reportText(writer, "\nDate & Time: ");
+        reportInt(writer, date_time.dayofmonth);
+        reportText(writer, " (day of the month) ");
+        reportInt(writer, date_time.hourofday);
+        reportChar(writer, ':');
+        reportInt(writer, date_time.minuteofhour);
+        reportText(writer, " (time)\n\n");
     }
 }
 
 
 // Function to print the sorted report
-void printReport(struct ProductionLine_Log logs_data[], int size) 
+void printReport(struct ProductionLine_Log logs_data[], int size, enum ReportFormat format) 
 {
-    printf("Sorted Production Line Report:\n");
+    struct ReportWriter writer;
+    openReportWriter(&writer, format);
+    beginSortedReport(&writer);
 
     for (int i = 0; i < size; i++) 
     {
-        printf("Product ID: %d\n", logs_data[i].ProductId);
-        printf("Issue Code: %d\n", logs_data[i].IssueCode);
-        printf("Date & Time: %d (day of the month) %d:%d (time)\n", logs_data[i].BatchDateTime.dayofmonth, logs_data[i].BatchDateTime.hourofday, logs_data[i].BatchDateTime.minuteofhour);
-        printf("\n");
+        writeSortedLog(&writer, logs_data[i].ProductId, logs_data[i].IssueCode, logs_data[i].BatchDateTime);
+    }
+    closeReportWriter(&writer);
+}
+
+
+// Function to print the sorted report from the log store
+void printStoreReport(const struct LogStore *store, enum ReportFormat format) 
+{
+    struct ReportWriter writer;
+    openReportWriter(&writer, format);
+    beginSortedReport(&writer);
+
+    for (int i = 0; i < store->size; i++) 
+    {
+        writeSortedLog(&writer, store->ProductId[i], store->IssueCode[i], unpackDateTime(store->BatchDateTime[i]));
+    }
+    closeReportWriter(&writer);
+}
+
+
+// Signature of a task run by the thread pool: task is a number from 0 to task_count - 1
+typedef void (*PoolTaskFunction)(void *context, int task);
+
+// Define a queue of task numbers owned by one worker
+// The owner and any idle worker both take tasks from the front, so an idle worker steals whatever is left
+struct TaskQueue
+{
+    atomic_int next;
+    int end;
+};
+
+// Define a work-stealing thread pool running one batch of tasks
+struct ThreadPool
+{
+    int thread_count;
+    struct TaskQueue *queues;
+    PoolTaskFunction run_task;
+    void *context;
+};
+
+// Define the arguments of one pool worker thread
+struct PoolWorker
+{
+    struct ThreadPool *pool;
+    int id;
+};
+
+
+// Worker loop: run the tasks of the worker's own queue, then steal from the other queues until all are empty
+void *poolWorkerMain(void *argument)
+{
+    struct PoolWorker *worker = (struct PoolWorker *)argument;
+    struct ThreadPool *pool = worker->pool;
+
+    for (int offset = 0; offset < pool->thread_count; offset++)
+    {
+        struct TaskQueue *queue = &pool->queues[(worker->id + offset) % pool->thread_count];
+        int task;
+
+        while ((task = atomic_fetch_add(&queue->next, 1)) < queue->end)
+        {
+            pool->run_task(pool->context, task);
+        }
     }
+
+    // Hand the counts of this thread over before it exits
+    TRACE_FLUSH();
+    return NULL;
 }
 
 
-int main() 
+// Function to run tasks 0 to task_count - 1 on thread_count threads, the calling thread being one of them
+// Tasks are dealt out in contiguous ranges and idle threads steal from busy ones
+// Returns 0 if the pool could not be allocated; if some threads fail to start, the others run their tasks
+int runParallelTasks(int thread_count, int task_count, PoolTaskFunction run_task, void *context)
 {
-    // Example ProductionLine_Log array
-    struct ProductionLine_Log logs_data[] = 
+    struct TaskQueue *queues = (struct TaskQueue *)malloc((size_t)thread_count * sizeof(struct TaskQueue));
+    struct PoolWorker *workers = (struct PoolWorker *)malloc((size_t)thread_count * sizeof(struct PoolWorker));
+    pthread_t *threads = (pthread_t *)malloc((size_t)thread_count * sizeof(pthread_t));
+    int *started = (int *)calloc((size_t)thread_count, sizeof(int));
+
+    if (queues == NULL || workers == NULL || threads == NULL || started == NULL)
     {
-        {1, 101, {1, 20, 45}, 1001, 10, "Defect in wing", 10, "Resolved by replacing faulty component", 100},
-        {2, 102, {1, 5, 45}, 1003, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {5, 105, {1, 11, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 107, {1, 7, 45}, 1001, 1, "Product damage", 1, "Resolved by adding final quality checks", 100},
-        {9, 102, {1, 16, 45}, 1003, 3, "Shipping delay", 3, "Resolved by increasing number of couriers", 105},
-        {6, 103, {1, 23, 45}, 1005, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 111, {1, 10, 45}, 1001, 17, "Transportation issue", 17, "Resolved by improving transportation methods", 100},
-        {3, 116, {1, 6, 45}, 1006, 20, "Customer complaint", 20, "Resolved with personalised solutions", 105},
-        {1, 109, {1, 22, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {8, 107, {1, 21, 45}, 1005, 6, "Labelling issue", 6, "Resolved by implementing revised labelling procedures", 100},
-        {7, 112, {1, 18, 45}, 1001, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {1, 108, {1, 4, 45}, 1007, 30, "Staff shortage", 30, "Resolved by hiring temporary staff", 102},    
-    };
+        free(queues);
+        free(workers);
+        free(threads);
+        free(started);
+        return 0;
+    }
 
-    // Determine the number of logs in the array to ensure that the logs_number variable holds the correct number of logs, even if the size of the array changes in the future
-    int logs_number = sizeof(logs_data) / sizeof(logs_data[0]);
+    struct ThreadPool pool = {thread_count, queues, run_task, context};
 
-    // Display logs_data
-    printf("Unsorted Production Line Report:\n");
+    // Deal the tasks out to the workers in contiguous ranges
+    for (int i = 0; i < thread_count; i++)
+    {
+        atomic_init(&queues[i].next, (int)((long long)task_count * i / thread_count));
+        queues[i].end = (int)((long long)task_count * (i + 1) / thread_count);
+        workers[i].pool = &pool;
+        workers[i].id = i;
+    }
+
+    for (int i = 1; i < thread_count; i++)
+    {
+        started[i] = pthread_create(&threads[i], NULL, poolWorkerMain, &workers[i]) == 0;
+    }
+    poolWorkerMain(&workers[0]);
 
-    for (int i = 0; i < logs_number; i++) 
+    for (int i = 1; i < thread_count; i++)
     {
-        printf("Production Line: %d\n", logs_data[i].LineCode);
-        printf("Batch Code: %d\n", logs_data[i].BatchCode);
-        printf("Batch Date & Time: %d (day of the month) %d:%d (time)\n", logs_data[i].BatchDateTime.dayofmonth, logs_data[i].BatchDateTime.hourofday, logs_data[i].BatchDateTime.minuteofhour);
-        printf("Product ID: %d\n", logs_data[i].ProductId);
-        printf("Issue Code: %d\n", logs_data[i].IssueCode);
-        printf("Issue Description: %s\n", logs_data[i].IssueDescription);
-        printf("Resolution Code: %d\n", logs_data[i].ResolutionCode);
-        printf("Resolution Description: %s\n", logs_data[i].ResolutionDescription);
-        printf("Reporting Employee ID: %d\n", logs_data[i].ReportingEmployeeId);
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    free(queues);
+    free(workers);
+    free(threads);
+    free(started);
+    return 1;
+}
+
+
+// Define the state shared by the tasks of one parallel index sort
+// Chunk c covers entries [c * chunk_size, (c + 1) * chunk_size) and output slice s is merged from
+// entries [bounds[s * chunk_count + c], bounds[(s + 1) * chunk_count + c]) of every chunk c
+struct ParallelSort
+{
+    const struct LogStore *store;
+    struct SortEntry *entries;
+    struct SortEntry *scratch;
+    int size;
+    int chunk_count;
+    int chunk_size;
+    int slice_count;
+    int *bounds;
+    int *slice_offsets;
+    atomic_int failed;
+};
+
+// Define a k-way merge heap item: the next entry of a chunk and the rest of the chunk's range
+struct MergeCursor
+{
+    struct SortEntry entry;
+    int position;
+    int end;
+};
+
+
+// Total order on entries used by the parallel merge: packed key first, then original position
+// The serial stable sorts produce exactly this order, which keeps the parallel output identical
+int entryLess(const struct SortEntry *a, const struct SortEntry *b)
+{
+    return a->key < b->key || (a->key == b->key && a->index < b->index);
+}
+
+
+// Function to find the first entry in entries[left..right-1] that is not less than target
+int entryLowerBound(const struct SortEntry entries[], int left, int right, const struct SortEntry *target)
+{
+    while (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        TRACE_COUNT(TRACE_PROBES, 1);
+        if (entryLess(&entries[mid], target))
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+
+// Restore the min-heap order of cursors[] below position i
+void siftDownCursor(struct MergeCursor cursors[], int count, int i)
+{
+    while (1)
+    {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        TRACE_COUNT(TRACE_COMPARISONS, (left < count) + (right < count));
+
+        if (left < count && entryLess(&cursors[left].entry, &cursors[smallest].entry))
+        {
+            smallest = left;
+        }
+        if (right < count && entryLess(&cursors[right].entry, &cursors[smallest].entry))
+        {
+            smallest = right;
+        }
+        if (smallest == i)
+        {
+            return;
+        }
+
+        struct MergeCursor swap = cursors[i];
+        cursors[i] = cursors[smallest];
+        cursors[smallest] = swap;
+        i = smallest;
+    }
+}
+
+
+// Pool task: build the (key, index) entries of one chunk and sort them in place
+void sortChunkTask(void *context, int chunk)
+{
+    struct ParallelSort *sort = (struct ParallelSort *)context;
+    int start = chunk * sort->chunk_size;
+    int end = start + sort->chunk_size < sort->size ? start + sort->chunk_size : sort->size;
+
+    if (!buildSortEntries(sort->store, start, end, sort->entries + start))
+    {
+        atomic_store(&sort->failed, 1);
+        return;
+    }
+
+    struct SortEntry *sorted = sortEntries(sort->entries + start, sort->scratch + start, end - start);
+    if (sorted != sort->entries + start)
+    {
+        memcpy(sort->entries + start, sorted, (size_t)(end - start) * sizeof(struct SortEntry));
+    }
+}
+
+
+// Pool task: k-way merge one output slice from the sorted chunks into scratch[]
+void mergeSliceTask(void *context, int slice)
+{
+    struct ParallelSort *sort = (struct ParallelSort *)context;
+    struct MergeCursor *cursors = (struct MergeCursor *)malloc((size_t)sort->chunk_count * sizeof(struct MergeCursor));
+    if (cursors == NULL)
+    {
+        atomic_store(&sort->failed, 1);
+        return;
+    }
+
+    // Collect the non-empty part of every chunk that falls inside this slice
+    int count = 0;
+    for (int chunk = 0; chunk < sort->chunk_count; chunk++)
+    {
+        int position = sort->bounds[slice * sort->chunk_count + chunk];
+        int end = sort->bounds[(slice + 1) * sort->chunk_count + chunk];
+        if (position < end)
+        {
+            cursors[count].entry = sort->entries[position];
+            cursors[count].position = position;
+            cursors[count].end = end;
+            count++;
+        }
+    }
+    for (int i = count / 2 - 1; i >= 0; i--)
+    {
+        siftDownCursor(cursors, count, i);
+    }
+
+    // Repeatedly output the smallest entry and advance its chunk
+    struct SortEntry *output = sort->scratch + sort->slice_offsets[slice];
+    while (count > 0)
+    {
+        *output++ = cursors[0].entry;
+        if (++cursors[0].position < cursors[0].end)
+        {
+            cursors[0].entry = sort->entries[cursors[0].position];
+        }
+        else
+        {
+            cursors[0] = cursors[--count];
+        }
+        siftDownCursor(cursors, count, 0);
+    }
+    TRACE_COUNT(TRACE_MOVES, output - (sort->scratch + sort->slice_offsets[slice]));
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+
+    free(cursors);
+}
+
+
+// Function to choose the slice boundaries of the parallel merge
+// Splitters are sampled evenly from every sorted chunk, and each chunk is then cut at each splitter by binary search
+int partitionSlices(struct ParallelSort *sort)
+{
+    int sample_count = sort->chunk_count * PARALLEL_SAMPLES_PER_CHUNK;
+    struct SortEntry *samples = (struct SortEntry *)malloc(2 * (size_t)sample_count * sizeof(struct SortEntry));
+    if (samples == NULL)
+    {
+        return 0;
+    }
+
+    int taken = 0;
+    for (int chunk = 0; chunk < sort->chunk_count; chunk++)
+    {
+        int start = chunk * sort->chunk_size;
+        int length = (start + sort->chunk_size < sort->size ? start + sort->chunk_size : sort->size) - start;
+        for (int i = 0; i < PARALLEL_SAMPLES_PER_CHUNK; i++)
+        {
+            samples[taken++] = sort->entries[start + (int)((long long)length * i / PARALLEL_SAMPLES_PER_CHUNK)];
+        }
+    }
+
+    // Samples are gathered chunk by chunk, so a stable sort by key leaves them in entryLess order
+    struct SortEntry *sorted = sortEntries(samples, samples + sample_count, sample_count);
+
+    for (int chunk = 0; chunk < sort->chunk_count; chunk++)
+    {
+        int start = chunk * sort->chunk_size;
+        int end = start + sort->chunk_size < sort->size ? start + sort->chunk_size : sort->size;
+
+        sort->bounds[chunk] = start;
+        sort->bounds[sort->slice_count * sort->chunk_count + chunk] = end;
+        for (int slice = 1; slice < sort->slice_count; slice++)
+        {
+            const struct SortEntry *splitter = &sorted[(int)((long long)sample_count * slice / sort->slice_count)];
+            sort->bounds[slice * sort->chunk_count + chunk] = entryLowerBound(sort->entries, start, end, splitter);
+        }
+    }
+
+    // Each slice starts where the entries of all earlier slices end
+    for (int slice = 0; slice <= sort->slice_count; slice++)
+    {
+        int offset = 0;
+        for (int chunk = 0; chunk < sort->chunk_count; chunk++)
+        {
+            offset += sort->bounds[slice * sort->chunk_count + chunk] - chunk * sort->chunk_size;
+        }
+        sort->slice_offsets[slice] = offset;
+    }
+
+    free(samples);
+    return 1;
+}
+
+
+// Parallel index-based sort of the log store in Product ID, Issue Code and Batch Date & Time order
+// The entries are built and sorted in chunks on a work-stealing pool, then merged by a parallel k-way merge
+// and the logs are moved once; the result is identical to indexSort()
+// Returns 0 if the logs could not be sorted this way, in which case the store is left unchanged
+int parallelIndexSort(struct LogStore *store, int thread_count)
+{
+    int size = store->size;
+    if (thread_count <= 1 || size < PARALLEL_MIN_SIZE)
+    {
+        return indexSort(store, sortEntries);
+    }
+
+    struct ParallelSort sort;
+    sort.store = store;
+    sort.size = size;
+    sort.chunk_count = thread_count * PARALLEL_CHUNKS_PER_THREAD;
+    sort.chunk_size = (size + sort.chunk_count - 1) / sort.chunk_count;
+    sort.chunk_count = (size + sort.chunk_size - 1) / sort.chunk_size;
+    sort.slice_count = sort.chunk_count;
+    atomic_init(&sort.failed, 0);
+
+    struct SortEntry *buffer = (struct SortEntry *)malloc(2 * (size_t)size * sizeof(struct SortEntry));
+    sort.bounds = (int *)malloc((size_t)(sort.slice_count + 1) * sort.chunk_count * sizeof(int));
+    sort.slice_offsets = (int *)malloc((size_t)(sort.slice_count + 1) * sizeof(int));
+
+    int sorted = 0;
+    if (buffer != NULL && sort.bounds != NULL && sort.slice_offsets != NULL)
+    {
+        sort.entries = buffer;
+        sort.scratch = buffer + size;
+
+        // Sort the chunks, split them into slices and merge every slice into scratch[]
+        sorted = runParallelTasks(thread_count, sort.chunk_count, sortChunkTask, &sort) &&
+                 !atomic_load(&sort.failed) &&
+                 partitionSlices(&sort) &&
+                 runParallelTasks(thread_count, sort.slice_count, mergeSliceTask, &sort) &&
+                 !atomic_load(&sort.failed);
+
+        sorted = sorted && applySortOrder(store, sort.scratch, sort.entries);
+    }
+
+    free(buffer);
+    free(sort.bounds);
+    free(sort.slice_offsets);
+    return sorted;
+}
+
+
+// Define a sorted run spilled to a temporary file and the buffer it is read back through during the merge
+struct SpillRun
+{
+    FILE *file;
+    struct SortEntry *buffer;
+    int count;             // Entries in the buffer
+    int position;          // Next entry of the buffer
+    int64_t remaining;     // Entries still in the file
+};
+
+// Define a tournament tree of losers over the runs of an external sort
+// losers[1..run_count-1] hold the run that lost the match at each internal node, winner the overall smallest run
+// Leaf r sits at position run_count + r, so the tree works for any number of runs
+struct LoserTree
+{
+    struct SpillRun *runs;
+    int *losers;
+    int run_count;
+    int winner;
+};
+
+
+// Function to check whether the next entry of run a comes before the next entry of run b
+// An exhausted run comes after every other run
+int runLess(const struct SpillRun runs[], int a, int b)
+{
+    TRACE_COUNT(TRACE_COMPARISONS, 1);
+    if (runs[a].position == runs[a].count)
+    {
+        return 0;
+    }
+    if (runs[b].position == runs[b].count)
+    {
+        return 1;
+    }
+    return entryLess(&runs[a].buffer[runs[a].position], &runs[b].buffer[runs[b].position]);
+}
+
+
+// Function to refill the buffer of a run from its file with one large read
+// Returns 0 if the file could not be read
+int refillSpillRun(struct SpillRun *run, int buffer_entries)
+{
+    run->position = 0;
+    run->count = run->remaining < buffer_entries ? (int)run->remaining : buffer_entries;
+    if (run->count > 0 && fread(run->buffer, sizeof(struct SortEntry), (size_t)run->count, run->file) != (size_t)run->count)
+    {
+        return 0;
+    }
+    run->remaining -= run->count;
+    return 1;
+}
+
+
+// Function to play the matches below node and return the winning run; the losers are kept in the tree
+int buildLoserTree(struct LoserTree *tree, int node)
+{
+    if (node >= tree->run_count)
+    {
+        return node - tree->run_count;
+    }
+
+    int left = buildLoserTree(tree, 2 * node);
+    int right = buildLoserTree(tree, 2 * node + 1);
+    if (runLess(tree->runs, right, left))
+    {
+        tree->losers[node] = left;
+        return right;
+    }
+    tree->losers[node] = right;
+    return left;
+}
+
+
+// Function to replay the matches from the leaf of the winning run up to the root after the run has advanced
+// Only one comparison per level is needed, against the loser stored at that level
+void replayLoserTree(struct LoserTree *tree)
+{
+    int winner = tree->winner;
+    for (int node = (winner + tree->run_count) / 2; node >= 1; node /= 2)
+    {
+        if (runLess(tree->runs, tree->losers[node], winner))
+        {
+            int loser = winner;
+            winner = tree->losers[node];
+            tree->losers[node] = loser;
+        }
+    }
+    tree->winner = winner;
+}
+
+
+// Function to add one log to the sorted report from its packed log key
+void writeSortedKey(struct ReportWriter *writer, uint64_t key)
+{
+    struct ProductionLine_Log log;
+    productIssueOrderUnpack(key, &log);
+    writeSortedLog(writer, log.ProductId, log.IssueCode, log.BatchDateTime);
+}
+
+
+// Function to release the runs of an external sort and close their temporary files
+void freeSpillRuns(struct SpillRun runs[], int run_count)
+{
+    for (int r = 0; r < run_count; r++)
+    {
+        if (runs[r].file != NULL)
+        {
+            fclose(runs[r].file);
+        }
+        free(runs[r].buffer);
+    }
+    free(runs);
+}
+
+
+// External-memory sort of the log store in Product ID, Issue Code and Batch Date & Time order, printing the sorted report
+// Runs of at most budget_bytes of (key, index) entries and scratch space are sorted in memory and spilled to temporary
+// files, then merged through a loser tree with one read buffer per run, sharing the same budget
+// Only the Product ID, Issue Code and Batch Date & Time columns are read, so a mapped store is never loaded whole
+// Returns 1 once the report is printed, 0 if the logs could not be sorted this way before anything was printed,
+// or -1 if a temporary file could not be read back part way through the report
+int externalSortReport(const struct LogStore *store, size_t budget_bytes, enum ReportFormat format)
+{
+    int size = store->size;
+    size_t run_entries = budget_bytes / (2 * sizeof(struct SortEntry));
+    run_entries = run_entries > EXTERNAL_MIN_RUN ? run_entries : EXTERNAL_MIN_RUN;
+    run_entries = run_entries < (size_t)INT32_MAX / 2 ? run_entries : (size_t)INT32_MAX / 2;
+    int run_size = size < (int)run_entries ? (size > 0 ? size : 1) : (int)run_entries;
+    int run_count = (size + run_size - 1) / run_size;
+
+    struct SpillRun *runs = (struct SpillRun *)calloc((size_t)(run_count > 0 ? run_count : 1), sizeof(struct SpillRun));
+    struct SortEntry *buffer = (struct SortEntry *)malloc(2 * (size_t)run_size * sizeof(struct SortEntry));
+    if (runs == NULL || buffer == NULL)
+    {
+        free(runs);
+        free(buffer);
+        return 0;
+    }
+
+    // Sort the runs one after another in the same buffer and write each to its own file in one large write
+    int spilled = 1;
+    for (int r = 0; r < run_count && spilled; r++)
+    {
+        int start = r * run_size;
+        int end = start + run_size < size ? start + run_size : size;
+        struct SortEntry *sorted = NULL;
+        runs[r].file = tmpfile();
+        runs[r].remaining = end - start;
+
+        spilled = runs[r].file != NULL &&
+                  buildSortEntries(store, start, end, buffer) &&
+                  (sorted = radixSortEntries(buffer, buffer + run_size, end - start)) != NULL &&
+                  fwrite(sorted, sizeof(struct SortEntry), (size_t)(end - start), runs[r].file) == (size_t)(end - start) &&
+                  fflush(runs[r].file) == 0;
+        if (spilled)
+        {
+            rewind(runs[r].file);
+        }
+    }
+    free(buffer);
+
+    // Split the budget into one read buffer per run
+    int buffer_entries = (int)(budget_bytes / sizeof(struct SortEntry) / (size_t)(run_count > 0 ? run_count : 1));
+    buffer_entries = buffer_entries > EXTERNAL_MIN_READ ? buffer_entries : EXTERNAL_MIN_READ;
+    buffer_entries = buffer_entries < run_size ? buffer_entries : run_size;
+
+    struct LoserTree tree;
+    tree.runs = runs;
+    tree.run_count = run_count;
+    tree.losers = (int *)malloc((size_t)(run_count > 0 ? run_count : 1) * sizeof(int));
+    for (int r = 0; r < run_count && spilled; r++)
+    {
+        runs[r].buffer = (struct SortEntry *)malloc((size_t)buffer_entries * sizeof(struct SortEntry));
+        spilled = runs[r].buffer != NULL && refillSpillRun(&runs[r], buffer_entries);
+    }
+    if (!spilled || tree.losers == NULL)
+    {
+        free(tree.losers);
+        freeSpillRuns(runs, run_count);
+        return 0;
+    }
+
+    // Stream the merged entries straight into the report
+    struct ReportWriter writer;
+    openReportWriter(&writer, format);
+    beginSortedReport(&writer);
+
+    int status = 1;
+    tree.winner = run_count > 0 ? buildLoserTree(&tree, 1) : 0;
+    for (int i = 0; i < size; i++)
+    {
+        struct SpillRun *run = &runs[tree.winner];
+        writeSortedKey(&writer, run->buffer[run->position].key);
+
+        if (++run->position == run->count && run->remaining > 0 && !refillSpillRun(run, buffer_entries))
+        {
+            status = -1;
+            break;
+        }
+        replayLoserTree(&tree);
+    }
+    closeReportWriter(&writer);
+    if (status < 0)
+    {
+        printf("Could not read back a sorted run.\n");
+    }
+
+    free(tree.losers);
+    freeSpillRuns(runs, run_count);
+    return status;
+}
+
+
+// Define a sort order kept up to date while logs are appended: a stack of sorted levels of (key, index) entries
+// (the logarithmic method). A new entry becomes a level of its own, and the newest level is merged into the one
+// below it while that one is not larger, so level sizes strictly decrease from the bottom up: there are at most
+// log2(N) + 1 levels and each entry is merged O(log N) times, which is amortised O(log N) per appended log
+struct LiveOrder
+{
+    struct SortEntry *levels[LIVE_ORDER_MAX_LEVELS];
+    int sizes[LIVE_ORDER_MAX_LEVELS];
+    int level_count;
+};
+
+
+// Function to release the levels of a live order
+void freeLiveOrder(struct LiveOrder *order)
+{
+    for (int l = 0; l < order->level_count; l++)
+    {
+        free(order->levels[l]);
+    }
+    order->level_count = 0;
+}
+
+
+// Function to merge the two newest levels of a live order into one
+// Returns 0 if memory could not be allocated, in which case the order is unchanged
+int mergeLiveLevels(struct LiveOrder *order)
+{
+    int older = order->level_count - 2;
+    int newer = order->level_count - 1;
+    const struct SortEntry *a = order->levels[older];
+    const struct SortEntry *b = order->levels[newer];
+    int a_size = order->sizes[older];
+    int b_size = order->sizes[newer];
+
+    struct SortEntry *merged = (struct SortEntry *)malloc((size_t)(a_size + b_size) * sizeof(struct SortEntry));
+    if (merged == NULL)
+    {
+        return 0;
+    }
+
+    int i = 0, j = 0, k = 0;
+    while (i < a_size && j < b_size)
+    {
+        merged[k++] = entryLess(&b[j], &a[i]) ? b[j++] : a[i++];
+    }
+    while (i < a_size)
+    {
+        merged[k++] = a[i++];
+    }
+    while (j < b_size)
+    {
+        merged[k++] = b[j++];
+    }
+
+    free(order->levels[older]);
+    free(order->levels[newer]);
+    order->levels[older] = merged;
+    order->sizes[older] = a_size + b_size;
+    order->level_count--;
+    return 1;
+}
+
+
+// Function to add sorted entries as the newest level of a live order, merging levels to restore decreasing sizes
+// The order takes ownership of entries
+// Returns 0 if memory could not be allocated
+int pushLiveLevel(struct LiveOrder *order, struct SortEntry *entries, int size)
+{
+    order->levels[order->level_count] = entries;
+    order->sizes[order->level_count] = size;
+    order->level_count++;
+
+    while (order->level_count > 1 && order->sizes[order->level_count - 2] <= order->sizes[order->level_count - 1])
+    {
+        if (!mergeLiveLevels(order))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+// Function to build a live order over every log of the store with one radix sort
+// Returns 0 if a log does not fit into a packed key or memory could not be allocated
+int buildLiveOrder(struct LiveOrder *order, const struct LogStore *store)
+{
+    memset(order, 0, sizeof(struct LiveOrder));
+    int size = store->size;
+    if (size == 0)
+    {
+        return 1;
+    }
+
+    struct SortEntry *buffer = (struct SortEntry *)malloc(2 * (size_t)size * sizeof(struct SortEntry));
+    struct SortEntry *sorted = NULL;
+    if (buffer == NULL || !buildSortEntries(store, 0, size, buffer) ||
+        (sorted = radixSortEntries(buffer, buffer + size, size)) == NULL)
+    {
+        free(buffer);
+        return 0;
+    }
+
+    // Keep only the sorted half
+    struct SortEntry *level = (struct SortEntry *)malloc((size_t)size * sizeof(struct SortEntry));
+    if (level == NULL)
+    {
+        free(buffer);
+        return 0;
+    }
+    memcpy(level, sorted, (size_t)size * sizeof(struct SortEntry));
+    free(buffer);
+    return pushLiveLevel(order, level, size);
+}
+
+
+// Function to add log row of the store to a live order in amortised O(log N)
+// Returns 0 if the log does not fit into a packed key or memory could not be allocated
+int addLiveOrderLog(struct LiveOrder *order, const struct LogStore *store, int row)
+{
+    struct SortEntry *entry = (struct SortEntry *)malloc(sizeof(struct SortEntry));
+    if (entry == NULL || order->level_count == LIVE_ORDER_MAX_LEVELS || !buildSortEntries(store, row, row + 1, entry))
+    {
+        free(entry);
+        return 0;
+    }
+    return pushLiveLevel(order, entry, 1);
+}
+
+
+// Function to bring a live order up to date with a log just appended to the store (LogAppendFunction)
+int appendLiveOrderLog(void *order, const struct LogStore *store, int row)
+{
+    return addLiveOrderLog((struct LiveOrder *)order, store, row);
+}
+
+
+// Function to print the sorted report of a live order by merging its levels on the fly
+// With at most log2(N) + 1 levels, the smallest head is found by a scan
+void printLiveOrderReport(const struct LiveOrder *order, int size, enum ReportFormat format)
+{
+    int positions[LIVE_ORDER_MAX_LEVELS] = {0};
+    struct ReportWriter writer;
+    openReportWriter(&writer, format);
+    beginSortedReport(&writer);
+
+    for (int i = 0; i < size; i++)
+    {
+        int best = -1;
+        for (int l = 0; l < order->level_count; l++)
+        {
+            if (positions[l] < order->sizes[l] &&
+                (best < 0 || entryLess(&order->levels[l][positions[l]], &order->levels[best][positions[best]])))
+            {
+                best = l;
+            }
+        }
+        writeSortedKey(&writer, order->levels[best][positions[best]++].key);
+    }
+    closeReportWriter(&writer);
+}
+
+
+// Usage: task1_assignment [merge|index|radix|adaptive|parallel [threads]|external [budget_mb]|live [new.csv]] [--logs file.qalog]
+//                         [--format text|csv|binary]
+// merge    - sort the logs with mergeSort (default)
+// index    - merge sort packed (key, index) entries and move each log once
+// radix    - LSD radix sort packed (key, index) entries and move each log once
+// adaptive - detect the runs already present in the logs, such as logs already in report order or with a few new logs
+//            appended, and merge only those runs (TimSort style), then move each log once
+// parallel - sort chunks of entries on a thread pool and merge them in parallel (default: one thread per processor)
+// external - sort runs of entries within a memory budget, spill them to temporary files and merge them into the report
+//            (default: 64 MB); its time on stderr includes printing the report
+// live     - keep a live sort order while the logs of new.csv ("-" for standard input) are appended one by one,
+//            then print the sorted report of all logs
+// The time spent sorting is written to stderr so the sort modes can be compared
+// --logs   - sort the logs of a binary log file instead of the example logs
+// --format - write the sorted report as text (default), CSV or binary records (see qa_report.h), without the unsorted listing
+// Build with -pthread
+int main(int argc, char *argv[]) 
+{
+    const char *logs_path = takeLogsOption(&argc, argv);
+    int report_format = takeFormatOption(&argc, argv);
+    const char *sort_mode = argc > 1 ? argv[1] : "merge";
+    EntrySortFunction sort_entries = NULL;
+    int thread_count = 0;
+    int budget_mb = 0;
+
+    if (report_format < 0)
+    {
+        return 1;
+    }
+
+    if (strcmp(sort_mode, "index") == 0)
+    {
+        sort_entries = sortEntries;
+    }
+    else if (strcmp(sort_mode, "radix") == 0)
+    {
+        sort_entries = radixSortEntries;
+    }
+    else if (strcmp(sort_mode, "adaptive") == 0)
+    {
+        sort_entries = adaptiveSortEntries;
+    }
+    else if (strcmp(sort_mode, "parallel") == 0)
+    {
+        thread_count = argc > 2 ? atoi(argv[2]) : defaultThreadCount();
+        if (thread_count < 1)
+        {
+            printf("Thread count must be at least 1.\n");
+            return 1;
+        }
+    }
+    else if (strcmp(sort_mode, "external") == 0)
+    {
+        budget_mb = argc > 2 ? atoi(argv[2]) : EXTERNAL_DEFAULT_BUDGET_MB;
+        if (budget_mb < 1)
+        {
+            printf("Memory budget must be at least 1 MB.\n");
+            return 1;
+        }
+    }
+    else if (strcmp(sort_mode, "merge") != 0 && strcmp(sort_mode, "live") != 0)
+    {
+        printf("Unknown sort mode: %s\n", sort_mode);
+        printf("Usage: %s [merge|index|radix|adaptive|parallel [threads]|external [budget_mb]|live [new.csv]] [--logs file.qalog] [--format text|csv|binary]\n", argv[0]);
+        return 1;
+    }
+
+    // Load the example QA logs, or the log file given with --logs, into the shared log store
+    struct LogStore store;
+    initLogStore(&store);
+    TRACE_BEGIN(load);
+    if (!loadTaskLogs(&store, logs_path))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(load);
+    int logs_number = store.size;
+
+    // Keep the sort order up to date while new logs are appended to the store
+    if (strcmp(sort_mode, "live") == 0)
+    {
+        struct LiveOrder order;
+        double live_start = currentTimeMs();
+        TRACE_BEGIN(sort);
+        int status = buildLiveOrder(&order, &store);
+        TRACE_END(sort);
+        if (!status)
+        {
+            printf("The logs could not be sorted: a Product ID or Issue Code is out of range or memory allocation failed.\n");
+        }
+        fprintf(stderr, "Sort mode live: %d logs sorted in %.3f ms\n", logs_number, currentTimeMs() - live_start);
+
+        TRACE_BEGIN(append);
+        status = status && (argc < 3 || appendCsvLogs(&store, argv[2], appendLiveOrderLog, &order));
+        TRACE_END(append);
+        if (status)
+        {
+            TRACE_BEGIN(report);
+            printLiveOrderReport(&order, store.size, (enum ReportFormat)report_format);
+            TRACE_END(report);
+        }
+
+        freeLiveOrder(&order);
+        freeLogStore(&store);
+        TRACE_DUMP();
+        return !status;
+    }
+
+    // Display logs_data; the CSV and binary reports hold the sorted logs only
+    TRACE_BEGIN(unsorted);
+    if (report_format == REPORT_TEXT)
+    {
+        printf("Unsorted Production Line Report:\n");
+    }
+
+    for (int i = 0; report_format == REPORT_TEXT && i < logs_number; i++) 
+    {
+        struct ProductionLine_Log log;
+        getLogRecord(&store, i, &log);
+
+        printf("Production Line: %d\n", log.LineCode);
+        printf("Batch Code: %d\n", log.BatchCode);
+        printf("Batch Date & Time: %d (day of the month) %d:%d (time)\n", log.BatchDateTime.dayofmonth, log.BatchDateTime.hourofday, log.BatchDateTime.minuteofhour);
+        printf("Product ID: %d\n", log.ProductId);
+        printf("Issue Code: %d\n", log.IssueCode);
+        printf("Issue Description: %s\n", log.IssueDescription);
+        printf("Resolution Code: %d\n", log.ResolutionCode);
+        printf("Resolution Description: %s\n", log.ResolutionDescription);
+        printf("Reporting Employee ID: %d\n", log.ReportingEmployeeId);
         printf("\n");
     }
+    TRACE_END(unsorted);
+
+    // Sort the logs based on Product ID, Issue Code and Batch Date & Time
+    // The index-based modes sort the store itself and fall back to merge sort if a log does not fit into a packed key
+    double sort_start = currentTimeMs();
+    TRACE_BEGIN(sort);
+
+    int sorted = 0;
+    int reported = 0;
+    if (budget_mb > 0)
+    {
+        // The external sort prints the report as it merges
+        reported = externalSortReport(&store, (size_t)budget_mb << 20, (enum ReportFormat)report_format);
+        if (reported < 0)
+        {
+            freeLogStore(&store);
+            return 1;
+        }
+        sorted = reported;
+    }
+    else if (thread_count > 0)
+    {
+        sorted = parallelIndexSort(&store, thread_count);
+    }
+    else if (sort_entries != NULL)
+    {
+        sorted = indexSort(&store, sort_entries);
+    }
 
-    // Perform merge sort on logs_data based on Product ID
-    mergeSort(logs_data, 0, logs_number - 1);
+    // Merge sort works on full records rebuilt from the store
+    struct ProductionLine_Log *logs_data = NULL;
+    if (!sorted)
+    {
+        logs_data = copyLogRecords(&store);
+        if (logs_data == NULL)
+        {
+            freeLogStore(&store);
+            return 1;
+        }
+        if (!mergeSort(logs_data, 0, logs_number - 1))
+        {
+            printf("Memory allocation failed.\n");
+            free(logs_data);
+            freeLogStore(&store);
+            return 1;
+        }
+    }
+    TRACE_END(sort);
+
+    fprintf(stderr, "Sort mode %s: %d logs sorted in %.3f ms\n", sort_mode, logs_number, currentTimeMs() - sort_start);
 
     // Print the sorted report
-    printReport(logs_data, logs_number);
+    TRACE_BEGIN(report);
+    if (reported)
+    {
+        // Already printed by the external sort
+    }
+    else if (sorted)
+    {
+        printStoreReport(&store, (enum ReportFormat)report_format);
+    }
+    else
+    {
+        printReport(logs_data, logs_number, (enum ReportFormat)report_format);
+    }
+    TRACE_END(report);
 
+    free(logs_data);
+    freeLogStore(&store);
+    TRACE_DUMP();
     return 0;
 }
\ No newline at end of file
@@ -29,41 +29,92 @@ Beatrice Maria Giurgica
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
-// Define DateTime structure
-struct DateTime
-{      
-    int dayofmonth;
-    int hourofday;
-    int minuteofhour;
-};
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_log_csv.h"
+#include "qa_trace.h"
+#include "qa_report.h"
+#include "qa_sort_key.h"
 
-// Define ProductionLine_Log structure
-struct ProductionLine_Log 
-{
-    int LineCode;
-    int BatchCode;
-    struct DateTime BatchDateTime;
-    int ProductId;
-    int IssueCode;
-    char IssueDescription[100];
-    int ResolutionCode;
-    char ResolutionDescription[100];
-    int ReportingEmployeeId;
-};
+// Report order of task 2: Product ID, then Line Code
+// Both fields take 32 bits, so every log has an exact key and a group is identified by the key of its logs
+#define PRODUCT_LINE_ORDER(FIELD) FIELD(PRODUCT_ID, 32) FIELD(LINE_CODE, 32)
+DEFINE_SORT_KEY(productLineOrder, PRODUCT_LINE_ORDER)
 
 // Define a linked list node for production line logs
+// The node refers to its log by row in the log store rather than holding a copy of it
 struct Node 
 {
-    struct ProductionLine_Log data;
+    int row;
     struct Node *next;
 };
 
+// Number of nodes in a standard arena slab
+#define NODES_PER_SLAB 4096
+
+// Define a slab of list nodes handed out one after another
+struct NodeSlab
+{
+    struct NodeSlab *next;
+    int capacity;
+    int used;
+    struct Node nodes[];
+};
+
+// Define an arena of list nodes: nodes are never freed one by one, the whole arena is released at once
+struct NodeArena
+{
+    struct NodeSlab *slabs; // Most recent slab first
+};
+
+
+// Function to take count consecutive nodes from the arena, adding a slab when the current one is full
+// Returns NULL if a new slab could not be allocated
+struct Node *allocNodes(struct NodeArena *arena, int count)
+{
+    struct NodeSlab *slab = arena->slabs;
+
+    if (slab == NULL || slab->capacity - slab->used < count)
+    {
+        int capacity = count > NODES_PER_SLAB ? count : NODES_PER_SLAB;
+        slab = (struct NodeSlab *)malloc(sizeof(struct NodeSlab) + (size_t)capacity * sizeof(struct Node));
+        if (slab == NULL)
+        {
+            return NULL;
+        }
+        TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+        slab->capacity = capacity;
+        slab->used = 0;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+    }
+
+    struct Node *nodes = &slab->nodes[slab->used];
+    slab->used += count;
+    return nodes;
+}
+
+
+// Function to release every node of the arena in one go
+void freeNodeArena(struct NodeArena *arena)
+{
+    while (arena->slabs != NULL)
+    {
+        struct NodeSlab *next = arena->slabs->next;
+        free(arena->slabs);
+        arena->slabs = next;
+    }
+}
+
+
 // Function to insert a log into the linked list while maintaining order based on Product ID and Line Code
-void insertLog(struct Node **head, struct ProductionLine_Log log) 
+// The node is taken from the arena and refers to row of the store, which must outlive the list
+void insertLog(struct NodeArena *arena, struct Node **head, const struct LogStore *store, int row) 
 {
     // Allocate memory for the new node
-    struct Node *newNode = (struct Node *)malloc(sizeof(struct Node));
+    struct Node *newNode = allocNodes(arena, 1);
     if (newNode == NULL) 
     {
         printf("Memory allocation failed.\n");
@@ -71,17 +122,18 @@ void insertLog(struct Node **head, struct ProductionLine_Log log)
     }
 
    
-    newNode->data = log; // Assign log data to the new node
+    newNode->row = row; // Refer the new node to the log data
     newNode->next = NULL; // Set next node in the list to be last node in the list
 
     struct Node *current = *head;
     struct Node *prev = NULL;
 
     // Navigate through the list to find the correct position based on Product ID and Line Code
-    while (current != NULL && (current->data.ProductId < newNode->data.ProductId || (current->data.ProductId == newNode->data.ProductId && current->data.LineCode < newNode->data.LineCode))) 
+    while (current != NULL && productLineOrderCompareRows(store, current->row, row) < 0) 
     {
         prev = current;
         current = current->next; // Move from current to next node in the list
+        TRACE_COUNT(TRACE_LIST_HOPS, 1);
     }   
 
     // Insert newNode at the correct position
@@ -96,52 +148,491 @@ void insertLog(struct Node **head, struct ProductionLine_Log log)
     }
 }
 
+// Define a group of logs sharing a Product ID and Line Code
+// Groups are numbered in order of first appearance while counting, and later positioned in report order
+struct LogGroup
+{
+    uint64_t key; // productLineOrderKey() of the logs of the group
+    int count;
+    int fill; // Next free report position of the group, filled from the end of its range
+};
+
+
+// Function to hash the (Product ID, Line Code) key of a group into a table of capacity slots (a power of two)
+unsigned int hashGroup(uint64_t key, unsigned int capacity)
+{
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(key >> 32) & (capacity - 1);
+}
+
+
+// qsort comparison placing groups in Product ID, then Line Code order
+int compareGroups(const void *a, const void *b)
+{
+    const struct LogGroup *left = (const struct LogGroup *)a;
+    const struct LogGroup *right = (const struct LogGroup *)b;
+
+    return (left->key > right->key) - (left->key < right->key);
+}
+
+
+// Function to build the report list ordered by Product ID and Line Code in O(N + G log G), G being the number of
+// distinct (Product ID, Line Code) pairs, instead of the O(N^2) of repeated insertLog() calls
+// Logs are counted per group through a hash table, the groups are given contiguous ranges of one block of arena
+// nodes (a counting sort), and the nodes are then linked in block order
+// Within a group the logs appear in the same order insertLog() gives them (latest inserted first)
+// Returns the head of the list, or NULL if the list is empty or allocation failed
+// Only the Product ID and Line Code columns of the store are read
+struct Node *buildGroupedList(struct NodeArena *arena, const struct LogStore *store)
+{
+    int logs_number = store->size;
+    if (logs_number <= 0)
+    {
+        return NULL;
+    }
+
+    // The hash table is kept at most half full
+    unsigned int capacity = 1;
+    while (capacity < 2 * (unsigned int)logs_number)
+    {
+        capacity *= 2;
+    }
+
+    int *table = (int *)malloc(capacity * sizeof(int));
+    int *group_of_log = (int *)malloc((size_t)logs_number * sizeof(int));
+    struct LogGroup *groups = (struct LogGroup *)malloc((size_t)logs_number * sizeof(struct LogGroup));
+    int *group_rank = (int *)malloc((size_t)logs_number * sizeof(int));
+    struct Node *nodes = allocNodes(arena, logs_number);
+
+    if (table == NULL || group_of_log == NULL || groups == NULL || group_rank == NULL || nodes == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        free(table);
+        free(group_of_log);
+        free(groups);
+        free(group_rank);
+        return NULL;
+    }
+    memset(table, -1, capacity * sizeof(int));
+    TRACE_COUNT(TRACE_ALLOCATIONS, 4);
+
+    // Count the logs of each (Product ID, Line Code) group
+    int group_count = 0;
+    for (int i = 0; i < logs_number; i++)
+    {
+        uint64_t key = productLineOrderKey(store, i);
+        unsigned int slot = hashGroup(key, capacity);
+
+        // Linear probing until the group or an empty slot is found
+        TRACE_COUNT(TRACE_PROBES, 1);
+        while (table[slot] != -1 && groups[table[slot]].key != key)
+        {
+            slot = (slot + 1) & (capacity - 1);
+            TRACE_COUNT(TRACE_PROBES, 1);
+        }
+
+        if (table[slot] == -1)
+        {
+            table[slot] = group_count;
+            groups[group_count].key = key;
+            groups[group_count].count = 0;
+            group_count++;
+        }
+
+        group_of_log[i] = table[slot];
+        groups[table[slot]].count++;
+    }
+
+    // Put the groups in report order and remember where each group moved to
+    for (int g = 0; g < group_count; g++)
+    {
+        groups[g].fill = g; // Temporarily holds the group number through the sort
+    }
+    qsort(groups, (size_t)group_count, sizeof(struct LogGroup), compareGroups);
+
+    // Give each group the end of its range of report positions
+    int end = 0;
+    for (int g = 0; g < group_count; g++)
+    {
+        group_rank[groups[g].fill] = g;
+        end += groups[g].count;
+        groups[g].fill = end;
+    }
+
+    // Place every log in its group, filling each group from the back as insertLog() puts new logs in front of equal ones
+    for (int i = 0; i < logs_number; i++)
+    {
+        int position = --groups[group_rank[group_of_log[i]]].fill;
+        nodes[position].row = i;
+    }
+    TRACE_COUNT(TRACE_MOVES, logs_number);
+
+    // Link the nodes in block order to form the single report list
+    for (int i = 0; i < logs_number - 1; i++)
+    {
+        nodes[i].next = &nodes[i + 1];
+    }
+    nodes[logs_number - 1].next = NULL;
+
+    free(table);
+    free(group_of_log);
+    free(groups);
+    free(group_rank);
+    return nodes;
+}
+
+// Define a (Product ID, Line Code) group of a live report list: the first and last node of its logs in the list
+struct LiveGroup
+{
+    uint64_t key; // productLineOrderKey() of the logs of the group
+    struct Node *first;
+    struct Node *last;
+};
+
+// Define a report list kept in Product ID and Line Code order while logs are appended one at a time
+// Groups are found through a hash table, and order[] lists the group numbers in report order so that the group
+// a new group follows can be found by binary search
+struct LiveList
+{
+    struct NodeArena arena;
+    struct Node *head;
+    struct LiveGroup *groups;
+    int *order;
+    int group_count;
+    int group_capacity;
+    int *table;                  // Group numbers, -1 when empty
+    unsigned int table_capacity; // Always a power of two
+};
+
+// Initial number of groups of a live list
+#define LIVE_LIST_INITIAL_GROUPS 256
+
+
+// Function to release a live list and all its nodes
+void freeLiveList(struct LiveList *list)
+{
+    freeNodeArena(&list->arena);
+    free(list->groups);
+    free(list->order);
+    free(list->table);
+    memset(list, 0, sizeof(struct LiveList));
+}
+
+
+// Function to find the table slot of a group, or the empty slot where it belongs
+unsigned int findLiveGroupSlot(const struct LiveList *list, uint64_t key)
+{
+    unsigned int slot = hashGroup(key, list->table_capacity);
+    TRACE_COUNT(TRACE_PROBES, 1);
+    while (list->table[slot] != -1 && list->groups[list->table[slot]].key != key)
+    {
+        slot = (slot + 1) & (list->table_capacity - 1);
+        TRACE_COUNT(TRACE_PROBES, 1);
+    }
+    return slot;
+}
+
+
+// Function to double the group capacity of a live list, rebuilding its hash table
+// Returns 0 if memory could not be allocated
+int growLiveGroups(struct LiveList *list)
+{
+    int capacity = list->group_capacity > 0 ? 2 * list->group_capacity : LIVE_LIST_INITIAL_GROUPS;
+    struct LiveGroup *groups = (struct LiveGroup *)realloc(list->groups, (size_t)capacity * sizeof(struct LiveGroup));
+    if (groups == NULL)
+    {
+        return 0;
+    }
+    list->groups = groups;
+
+    int *order = (int *)realloc(list->order, (size_t)capacity * sizeof(int));
+    int *table = (int *)malloc(2 * (size_t)capacity * sizeof(int));
+    if (order == NULL || table == NULL)
+    {
+        list->order = order != NULL ? order : list->order;
+        free(table);
+        return 0;
+    }
+    list->order = order;
+
+    // The hash table is kept at most half full
+    free(list->table);
+    list->table = table;
+    list->table_capacity = 2 * (unsigned int)capacity;
+    memset(table, -1, list->table_capacity * sizeof(int));
+    for (int g = 0; g < list->group_count; g++)
+    {
+        table[findLiveGroupSlot(list, groups[g].key)] = g;
+    }
+
+    list->group_capacity = capacity;
+    return 1;
+}
+
+
+// Function to find where a group belongs in order[]: the number of groups that come before it in the report
+int liveGroupRank(const struct LiveList *list, uint64_t key)
+{
+    int left = 0;
+    int right = list->group_count;
+    while (left < right)
+    {
+        int mid = left + (right - left) / 2;
+        const struct LiveGroup *group = &list->groups[list->order[mid]];
+        TRACE_COUNT(TRACE_PROBES, 1);
+        if (group->key < key)
+        {
+            left = mid + 1;
+        }
+        else
+        {
+            right = mid;
+        }
+    }
+    return left;
+}
+
+
+// Function to add log row of the store to a live list in the position insertLog() would give it
+// A log of an existing group is linked in front of the group in O(1): the new node is linked after the first node
+// of the group and takes over its row, so the first node stays first. A log opening a new group is linked after
+// the last node of the group before it, found by binary search over the G groups in O(log G); order[] then shifts,
+// which only happens once per group
+// Returns 0 if memory could not be allocated
+int addLiveLog(struct LiveList *list, const struct LogStore *store, int row)
+{
+    uint64_t key = productLineOrderKey(store, row);
+
+    if (list->group_count == list->group_capacity && !growLiveGroups(list))
+    {
+        return 0;
+    }
+    struct Node *node = allocNodes(&list->arena, 1);
+    if (node == NULL)
+    {
+        return 0;
+    }
+
+    unsigned int slot = findLiveGroupSlot(list, key);
+    if (list->table[slot] != -1)
+    {
+        struct LiveGroup *group = &list->groups[list->table[slot]];
+        node->row = group->first->row;
+        node->next = group->first->next;
+        group->first->row = row;
+        group->first->next = node;
+        if (group->last == group->first)
+        {
+            group->last = node;
+        }
+        return 1;
+    }
+
+    // Link the node of the new group after the group before it, or at the head of the list
+    int rank = liveGroupRank(list, key);
+    node->row = row;
+    if (rank > 0)
+    {
+        struct Node *previous = list->groups[list->order[rank - 1]].last;
+        node->next = previous->next;
+        previous->next = node;
+    }
+    else
+    {
+        node->next = list->head;
+        list->head = node;
+    }
+
+    int g = list->group_count++;
+    list->groups[g].key = key;
+    list->groups[g].first = node;
+    list->groups[g].last = node;
+    list->table[slot] = g;
+    memmove(&list->order[rank + 1], &list->order[rank], (size_t)(g - rank) * sizeof(int));
+    TRACE_COUNT(TRACE_MOVES, g - rank);
+    list->order[rank] = g;
+    return 1;
+}
+
+
+// Function to bring a live list up to date with a log just appended to the store (LogAppendFunction)
+int appendLiveLog(void *list, const struct LogStore *store, int row)
+{
+    return addLiveLog((struct LiveList *)list, store, row);
+}
+
+
 // Function to generate and print the report
-void generateReport(struct Node *head) 
+// The lines are formatted into a ReportWriter buffer rather than with one printf call per node
+void generateReport(const struct LogStore *store, struct Node *head, enum ReportFormat format) 
 {
     struct Node *current = head;
-    printf("QA Report:\n");
+    struct ReportWriter writer;
+    openReportWriter(&writer, format);
+
+    if (format == REPORT_CSV)
+    {
+        reportText(&writer, "ProductId,LineCode,IssueCode\n");
+    }
+    else if (format == REPORT_BINARY)
+    {
+        reportBinaryHeader(&writer, 3);
+    }
+    else
+    {
+        reportText(&writer, "QA Report:\n");
+    }
 
     // Print log details
     while (current != NULL) 
     {
-        printf("Product ID: %d  Line Code: %d  Issue Code: %d\n", current->data.ProductId, current->data.LineCode, current->data.IssueCode);
+        int row = current->row;
+        if (format == REPORT_CSV)
+        {
+            reportInt(&writer, store->ProductId[row]);
+            reportChar(&writer, ',');
+            reportInt(&writer, store->LineCode[row]);
+            reportChar(&writer, ',');
+            reportInt(&writer, store->IssueCode[row]);
+            reportChar(&writer, '\n');
+        }
+        else if (format == REPORT_BINARY)
+        {
+            reportInt32(&writer, store->ProductId[row]);
+            reportInt32(&writer, store->LineCode[row]);
+            reportInt32(&writer, store->IssueCode[row]);
+        }
+        else
+        {
+            reportText(&writer, "Product ID: ");
+            reportInt(&writer, store->ProductId[row]);
+            reportText(&writer, "  Line Code: ");
+            reportInt(&writer, store->LineCode[row]);
+            reportText(&writer, "  Issue Code: ");
+            reportInt(&writer, store->IssueCode[row]);
+            reportChar(&writer, '\n');
+        }
         current = current->next;
+        TRACE_COUNT(TRACE_LIST_HOPS, 1);
     }
+
+    closeReportWriter(&writer);
 }
 
-int main() {
-    // Example ProductionLine_Log array
-    struct ProductionLine_Log logs_data[] = 
-    {
-        {1, 101, {1, 20, 45}, 1001, 10, "Defect in wing", 10, "Resolved by replacing faulty component", 100},
-        {2, 102, {1, 5, 45}, 1003, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {5, 105, {1, 11, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 107, {1, 7, 45}, 1001, 1, "Product damage", 1, "Resolved by adding final quality checks", 100},
-        {9, 102, {1, 16, 45}, 1003, 3, "Shipping delay", 3, "Resolved by increasing number of couriers", 105},
-        {6, 103, {1, 23, 45}, 1005, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 111, {1, 10, 45}, 1001, 17, "Transportation issue", 17, "Resolved by improving transportation methods", 100},
-        {3, 116, {1, 6, 45}, 1006, 20, "Customer complaint", 20, "Resolved with personalised solutions", 105},
-        {1, 109, {1, 22, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {8, 107, {1, 21, 45}, 1005, 6, "Labelling issue", 6, "Resolved by implementing revised labelling procedures", 100},
-        {7, 112, {1, 18, 45}, 1001, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {1, 108, {1, 4, 45}, 1007, 30, "Staff shortage", 30, "Resolved by hiring temporary staff", 102},    
-    };
-
-    // Determine the number of logs in the array to ensure that the logs_number variable holds the correct number of logs, even if the size of the array changes in the future
-    int logs_number = sizeof(logs_data) / sizeof(logs_data[0]);
-
-    // Create an empty linked list
+// Usage: task2_assignment [bucket|insert|live [new.csv]] [--logs file.qalog] [--format text|csv|binary]
+// bucket - build the report list with the linear-time grouping engine (default)
+// insert - build the report list by inserting every log with insertLog()
+// live   - build the report list one log at a time with addLiveLog(), then keep adding the logs of new.csv
+//          ("-" for standard input) as they arrive
+// --logs - list the logs of a binary log file instead of the example logs
+// --format - write the report as text (default), CSV or binary records (see qa_report.h)
+// The time spent building the list is written to stderr so the two engines can be compared
+int main(int argc, char *argv[])
+{
+    const char *logs_path = takeLogsOption(&argc, argv);
+    int report_format = takeFormatOption(&argc, argv);
+    const char *build_mode = argc > 1 ? argv[1] : "bucket";
+
+    if (report_format < 0)
+    {
+        return 1;
+    }
+
+    if (strcmp(build_mode, "bucket") != 0 && strcmp(build_mode, "insert") != 0 && strcmp(build_mode, "live") != 0)
+    {
+        printf("Unknown build mode: %s\n", build_mode);
+        printf("Usage: %s [bucket|insert|live [new.csv]] [--logs file.qalog] [--format text|csv|binary]\n", argv[0]);
+        return 1;
+    }
+
+    // Load the example QA logs, or the log file given with --logs, into the shared log store
+    struct LogStore store;
+    initLogStore(&store);
+    TRACE_BEGIN(load);
+    if (!loadTaskLogs(&store, logs_path))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(load);
+    int logs_number = store.size;
+
+    // Keep the list up to date while new logs are appended to the store
+    if (strcmp(build_mode, "live") == 0)
+    {
+        struct LiveList list;
+        memset(&list, 0, sizeof(struct LiveList));
+        double live_start = currentTimeMs();
+        TRACE_BEGIN(build);
+
+        int status = 1;
+        for (int i = 0; status && i < logs_number; i++)
+        {
+            status = addLiveLog(&list, &store, i);
+        }
+        TRACE_END(build);
+        if (!status)
+        {
+            printf("Memory allocation failed.\n");
+        }
+        fprintf(stderr, "Build mode live: %d logs listed in %.3f ms\n", logs_number, currentTimeMs() - live_start);
+
+        TRACE_BEGIN(append);
+        status = status && (argc < 3 || appendCsvLogs(&store, argv[2], appendLiveLog, &list));
+        TRACE_END(append);
+        if (status)
+        {
+            TRACE_BEGIN(report);
+            generateReport(&store, list.head, (enum ReportFormat)report_format);
+            TRACE_END(report);
+        }
+
+        freeLiveList(&list);
+        freeLogStore(&store);
+        TRACE_DUMP();
+        return !status;
+    }
+
+    // Create an empty linked list and the arena holding its nodes
     struct Node *head = NULL;
+    struct NodeArena arena = {NULL};
+    double build_start = currentTimeMs();
+    TRACE_BEGIN(build);
+
+    if (strcmp(build_mode, "bucket") == 0)
+    {
+        // Build the whole ordered list at once from one block of nodes
+        head = buildGroupedList(&arena, &store);
+    }
+    else
+    {
+        // Insert logs into the linked list while maintaining order
+        for (int i = 0; i < logs_number; i++) 
+        {
+            insertLog(&arena, &head, &store, i);
+        }
+    }
+    TRACE_END(build);
 
-    // Insert logs into the linked list while maintaining order
-    for (int i = 0; i < logs_number; i++) 
+    // An empty list from a store with logs means its nodes could not be allocated
+    if (head == NULL && store.size > 0)
     {
-        insertLog(&head, logs_data[i]);
+        freeNodeArena(&arena);
+        freeLogStore(&store);
+        return 1;
     }
 
+    fprintf(stderr, "Build mode %s: %d logs listed in %.3f ms\n", build_mode, logs_number, currentTimeMs() - build_start);
+
     // Generate and print the report
-    generateReport(head);
+    TRACE_BEGIN(report);
+    generateReport(&store, head, (enum ReportFormat)report_format);
+    TRACE_END(report);
+
+    // Release all list nodes at once
+    freeNodeArena(&arena);
+    freeLogStore(&store);
+    TRACE_DUMP();
 
     return 0;
 }
\ No newline at end of file
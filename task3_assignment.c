@@ -26,101 +26,715 @@ Beatrice Maria Giurgica
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 
-// Define DateTime structure
-struct DateTime
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_trace.h"
+#include "qa_sort_key.h"
+#include "qa_time_index.h"
+#include "qa_archive.h"
+#include "qa_log_index.h"
+
+// Define the sorted search index built once over the log store: the packed (Product ID, Issue Code, Batch Date & Time)
+// key of every log and its row in the log store, in key order
+struct SearchIndex
 {
-    int dayofmonth;
-    int hourofday;
-    int minuteofhour;
+    struct SortEntry *entries;
+    int size;
 };
 
-// Define ProductionLine_Log structure
-struct ProductionLine_Log
-{
-    int LineCode;
-    int BatchCode;
-    struct DateTime BatchDateTime;
-    int ProductId;
-    int IssueCode;
-    char IssueDescription[100];
-    int ResolutionCode;
-    char ResolutionDescription[100];
-    int ReportingEmployeeId;
+// Define the search index keys laid out in Eytzinger order: node k has children 2k and 2k + 1
+// A search touches the nodes top-down, so the first levels stay in cache and the rest can be prefetched
+struct EytzingerIndex
+{
+    uint64_t *keys;
+    int *positions; // Row in the log store of each node's log
+    int size;
 };
 
-// Binary search function to find the earliest occurrence of issue code for a product ID
-int searchEarliestOccurrence(struct ProductionLine_Log logs_data[], int logs_number, int productID)
+// Number of queries the measure mode also answers with a linear scan
+#define LINEAR_SCAN_QUERIES 100
+
+// The Eytzinger search prefetches the descendants this many levels below the current node
+// 2^4 keys of 8 bytes are two cache lines
+#define EYTZINGER_PREFETCH_LEVELS 4
+
+// Longest line of a query file, including its newline
+#define QUERY_LINE_LENGTH 256
+
+// TRAILING_ONES(value) counts the low 1 bits of an unsigned int that is not all ones
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#define TRAILING_ONES(value) __builtin_ctz(~(value))
+#else
+#define PREFETCH(address) ((void)0)
+#define TRAILING_ONES(value) countTrailingOnes(value)
+
+// Function to count the low 1 bits of value, for compilers without __builtin_ctz
+static int countTrailingOnes(unsigned int value)
+{
+    int count = 0;
+    while (value & 1u)
+    {
+        value >>= 1;
+        count++;
+    }
+    return count;
+}
+#endif
+
+
+// Function to build the sorted search index over the log store once, in O(N)
+// Only the Product ID, Issue Code and Batch Date & Time columns are read
+// Returns 0 if the index could not be allocated or a log does not fit into a packed search key
+int buildSearchIndex(struct SearchIndex *index, const struct LogStore *store)
+{
+    index->size = 0;
+    index->entries = sortLogKeyEntries(store, "indexed");
+    if (index->entries == NULL)
+    {
+        return 0;
+    }
+    index->size = store->size;
+    return 1;
+}
+
+
+// Function to release the search index
+void freeSearchIndex(struct SearchIndex *index)
+{
+    free(index->entries);
+    index->entries = NULL;
+    index->size = 0;
+}
+
+
+// Binary search function to find the earliest occurrence of an issue code for a product ID across all production lines
+// A lower-bound search for the smallest possible date & time of (productID, issueCode) lands on the earliest match
+// in O(Log(N)); returns its row in the log store, or -1 if there is none
+int searchEarliestOccurrence(const struct SearchIndex *index, int productID, int issueCode)
 {
+    if (!fitsLogKey(productID, issueCode))
+    {
+        return -1;
+    }
+
+    uint64_t target = packLogKey(productID, issueCode, 0);
     int left = 0;
-    int right = logs_number - 1;
-    int earliestIndex = -1; // Value not found yet
+    int right = index->size;
 
-    while (left <= right)
+    while (left < right)
     {
         // Calculate mid point
         int mid = left + (right - left) / 2;
+        TRACE_COUNT(TRACE_PROBES, 1);
 
-        // Check if the current log matches the productID
-        if (logs_data[mid].ProductId == productID)
+        if (index->entries[mid].key < target)
         {
-            earliestIndex = mid;
-            return earliestIndex;
+            left = mid + 1;  // The earliest match is in the right subarray
         }
-        else if (logs_data[mid].ProductId > productID)
+        else
         {
-            // Search in the left subarray
-            right = mid - 1;  // Update right value of left subarray to restrict the search
+            right = mid;  // The earliest match is at mid or in the left subarray
+        }
+    }
+
+    // Check that the entry found belongs to the requested product and issue code
+    if (left < index->size && (index->entries[left].key >> LOG_KEY_DATE_TIME_BITS) == (target >> LOG_KEY_DATE_TIME_BITS))
+    {
+        return index->entries[left].index;
+    }
+    return -1;
+}
+
+
+// Function to find the earliest occurrence of an issue code for a product ID by scanning every log, in O(N)
+// Used as the reference that the indexed search is measured against
+int linearEarliestOccurrence(const struct LogStore *store, int productID, int issueCode)
+{
+    int earliestIndex = -1;
+    int earliest_date_time = 0;
+
+    for (int i = 0; i < store->size; i++)
+    {
+        if (store->ProductId[i] == productID && store->IssueCode[i] == issueCode)
+        {
+            int date_time = store->BatchDateTime[i];
+            if (earliestIndex == -1 || date_time < earliest_date_time)
+            {
+                earliestIndex = i;
+                earliest_date_time = date_time;
+            }
+        }
+    }
+    TRACE_COUNT(TRACE_SCANS, store->size);
+    return earliestIndex;
+}
+
+
+// Function to measure the lookup latency of the indexed search against a linear scan on a synthetic log
+int measureSearch(int logs_number, int query_count)
+{
+    uint64_t random_state = 88172645463325252ULL;
+    struct LogStore store;
+    initLogStore(&store);
+    int *queries = (int *)malloc(2 * (size_t)query_count * sizeof(int));
+    if (queries == NULL || !generateLogs(&store, logs_number, &random_state))
+    {
+        freeLogStore(&store);
+        free(queries);
+        return 1;
+    }
+
+    for (int q = 0; q < query_count; q++)
+    {
+        queries[2 * q] = 1000 + (int)(nextRandom(&random_state) % 1000);
+        queries[2 * q + 1] = 1 + (int)(nextRandom(&random_state) % 50);
+    }
+
+    struct SearchIndex index;
+    double start = currentTimeMs();
+    TRACE_BEGIN(index);
+    if (!buildSearchIndex(&index, &store))
+    {
+        freeLogStore(&store);
+        free(queries);
+        return 1;
+    }
+    TRACE_END(index);
+    printf("Index of %d logs built in %.3f ms\n", logs_number, currentTimeMs() - start);
+
+    // Answer every query through the index
+    long long found = 0;
+    start = currentTimeMs();
+    TRACE_BEGIN(search);
+    for (int q = 0; q < query_count; q++)
+    {
+        found += searchEarliestOccurrence(&index, queries[2 * q], queries[2 * q + 1]) != -1;
+    }
+    TRACE_END(search);
+    double indexed_ms = currentTimeMs() - start;
+    printf("Indexed search: %d queries (%lld found) in %.3f ms, %.3f us per lookup\n",
+           query_count, found, indexed_ms, indexed_ms * 1000.0 / query_count);
+
+    // Answer the first queries with a linear scan as well and check that both agree
+    int linear_count = query_count < LINEAR_SCAN_QUERIES ? query_count : LINEAR_SCAN_QUERIES;
+    int mismatches = 0;
+    start = currentTimeMs();
+    TRACE_BEGIN(scan);
+    for (int q = 0; q < linear_count; q++)
+    {
+        int expected = linearEarliestOccurrence(&store, queries[2 * q], queries[2 * q + 1]);
+        mismatches += expected != searchEarliestOccurrence(&index, queries[2 * q], queries[2 * q + 1]);
+    }
+    TRACE_END(scan);
+    double linear_ms = currentTimeMs() - start;
+    printf("Linear scan: %d queries in %.3f ms, %.3f us per lookup\n", linear_count, linear_ms, linear_ms * 1000.0 / linear_count);
+
+    if (mismatches > 0)
+    {
+        printf("%d queries gave a different result from the linear scan.\n", mismatches);
+    }
+
+    freeSearchIndex(&index);
+    freeLogStore(&store);
+    free(queries);
+    return mismatches > 0;
+}
+
+// Function to lay out the sorted keys in Eytzinger (breadth-first binary tree) order
+// position is the next sorted entry to place and node the tree node to fill; returns the next sorted entry
+int fillEytzinger(struct EytzingerIndex *eytzinger, const struct SearchIndex *index, int position, int node)
+{
+    if (node <= eytzinger->size)
+    {
+        // In-order traversal of the implicit tree visits the nodes in sorted key order
+        position = fillEytzinger(eytzinger, index, position, 2 * node);
+        eytzinger->keys[node] = index->entries[position].key;
+        eytzinger->positions[node] = index->entries[position].index;
+        position++;
+        position = fillEytzinger(eytzinger, index, position, 2 * node + 1);
+    }
+    return position;
+}
+
+
+// Function to build the Eytzinger copy of a sorted search index
+// Returns 0 if the arrays could not be allocated
+int buildEytzingerIndex(struct EytzingerIndex *eytzinger, const struct SearchIndex *index)
+{
+    // Node 0 is unused so that the children of node k are 2k and 2k + 1
+    eytzinger->size = index->size;
+    eytzinger->keys = (uint64_t *)malloc((size_t)(index->size + 1) * sizeof(uint64_t));
+    eytzinger->positions = (int *)malloc((size_t)(index->size + 1) * sizeof(int));
+    if (eytzinger->keys == NULL || eytzinger->positions == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        free(eytzinger->keys);
+        free(eytzinger->positions);
+        return 0;
+    }
+
+    fillEytzinger(eytzinger, index, 0, 1);
+    return 1;
+}
+
+
+// Function to release the Eytzinger index
+void freeEytzingerIndex(struct EytzingerIndex *eytzinger)
+{
+    free(eytzinger->keys);
+    free(eytzinger->positions);
+    eytzinger->keys = NULL;
+    eytzinger->positions = NULL;
+    eytzinger->size = 0;
+}
+
+
+// Eytzinger-layout version of searchEarliestOccurrence(), giving the same result
+// The descent is branch-free and prefetches the cache line of the node EYTZINGER_PREFETCH_LEVELS levels further down
+int searchEarliestEytzinger(const struct EytzingerIndex *eytzinger, int productID, int issueCode)
+{
+    if (!fitsLogKey(productID, issueCode))
+    {
+        return -1;
+    }
+
+    uint64_t target = packLogKey(productID, issueCode, 0);
+    unsigned int node = 1;
+
+    while (node <= (unsigned int)eytzinger->size)
+    {
+        PREFETCH(eytzinger->keys + ((size_t)node << EYTZINGER_PREFETCH_LEVELS));
+        node = 2 * node + (eytzinger->keys[node] < target);
+        TRACE_COUNT(TRACE_PROBES, 1);
+    }
+
+    // Undo the right turns taken after the last left turn, which lands on the lower bound (0 if there is none)
+    node >>= TRAILING_ONES(node) + 1;
+
+    if (node != 0 && (eytzinger->keys[node] >> LOG_KEY_DATE_TIME_BITS) == (target >> LOG_KEY_DATE_TIME_BITS))
+    {
+        return eytzinger->positions[node];
+    }
+    return -1;
+}
+
+
+// Function to read the (Product ID, Issue Code) pairs of a query file, one pair per line, blank lines skipped
+// Returns the number of queries read and sets *queries to them, or returns -1 and prints the reason if the file could
+// not be read or a line is not a pair
+int readQueries(const char *path, int **queries)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        printf("Cannot open query file %s.\n", path);
+        return -1;
+    }
+
+    int capacity = 1024;
+    int count = 0;
+    int *pairs = (int *)malloc(2 * (size_t)capacity * sizeof(int));
+    int line_number = 0;
+    int valid = 1;
+    char line[QUERY_LINE_LENGTH];
+
+    while (pairs != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+        int productID;
+        int issueCode;
+        char rest;
+        if (line[strspn(line, " \t\r\n")] == '\0')
+        {
+            continue;
+        }
+        if (sscanf(line, "%d %d %c", &productID, &issueCode, &rest) != 2)
+        {
+            printf("Line %d of query file %s is not valid.\n", line_number, path);
+            valid = 0;
+            break;
+        }
+
+        if (count == capacity)
+        {
+            capacity *= 2;
+            int *grown = (int *)realloc(pairs, 2 * (size_t)capacity * sizeof(int));
+            if (grown == NULL)
+            {
+                free(pairs);
+                pairs = NULL;
+                break;
+            }
+            pairs = grown;
+        }
+        pairs[2 * count] = productID;
+        pairs[2 * count + 1] = issueCode;
+        count++;
+    }
+    fclose(file);
+
+    if (pairs == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        return -1;
+    }
+    if (!valid)
+    {
+        free(pairs);
+        return -1;
+    }
+    *queries = pairs;
+    return count;
+}
+
+
+// Function to answer every query of a query file against one index over the log store
+// Results are streamed to stdout, one line per query in file order, and the queries per second of the
+// Eytzinger search and of repeated searchEarliestOccurrence() calls are written to stderr
+int runBatchQueries(const struct LogStore *store, const char *query_path)
+{
+    int *queries = NULL;
+    int query_count = readQueries(query_path, &queries);
+    if (query_count < 0)
+    {
+        return 1;
+    }
+
+    struct SearchIndex index;
+    struct EytzingerIndex eytzinger;
+    int *results = (int *)malloc((size_t)(query_count > 0 ? query_count : 1) * sizeof(int));
+    TRACE_BEGIN(index);
+    if (results == NULL || !buildSearchIndex(&index, store))
+    {
+        free(queries);
+        free(results);
+        return 1;
+    }
+    if (!buildEytzingerIndex(&eytzinger, &index))
+    {
+        freeSearchIndex(&index);
+        free(queries);
+        free(results);
+        return 1;
+    }
+    TRACE_END(index);
+
+    // Answer the batch through the Eytzinger index
+    double start = currentTimeMs();
+    TRACE_BEGIN(eytzinger);
+    for (int q = 0; q < query_count; q++)
+    {
+        results[q] = searchEarliestEytzinger(&eytzinger, queries[2 * q], queries[2 * q + 1]);
+    }
+    TRACE_END(eytzinger);
+    double eytzinger_ms = currentTimeMs() - start;
+
+    // Answer the same batch with repeated calls to the sorted-array search for comparison
+    int mismatches = 0;
+    start = currentTimeMs();
+    TRACE_BEGIN(search);
+    for (int q = 0; q < query_count; q++)
+    {
+        mismatches += searchEarliestOccurrence(&index, queries[2 * q], queries[2 * q + 1]) != results[q];
+    }
+    TRACE_END(search);
+    double sorted_ms = currentTimeMs() - start;
+
+    // Stream the results
+    TRACE_BEGIN(report);
+    for (int q = 0; q < query_count; q++)
+    {
+        if (results[q] != -1)
+        {
+            struct DateTime date_time = unpackDateTime(store->BatchDateTime[results[q]]);
+            printf("Product ID: %d  Issue Code: %d  Index: %d  Line Code: %d  Date & Time: %d %d:%d\n", queries[2 * q], queries[2 * q + 1],
+                   results[q], store->LineCode[results[q]], date_time.dayofmonth, date_time.hourofday, date_time.minuteofhour);
         }
         else
         {
-            // Search in the right subarray
-            left = mid + 1;  // Update left value of right subarray to restrict the search
+            printf("Product ID: %d  Issue Code: %d  Not found\n", queries[2 * q], queries[2 * q + 1]);
         }
     }
+    TRACE_END(report);
 
-    return earliestIndex;
+    fprintf(stderr, "Eytzinger search: %d queries in %.3f ms (%.0f queries per second)\n",
+            query_count, eytzinger_ms, eytzinger_ms > 0 ? query_count * 1000.0 / eytzinger_ms : 0.0);
+    fprintf(stderr, "searchEarliestOccurrence: %d queries in %.3f ms (%.0f queries per second)\n",
+            query_count, sorted_ms, sorted_ms > 0 ? query_count * 1000.0 / sorted_ms : 0.0);
+    if (mismatches > 0)
+    {
+        fprintf(stderr, "%d queries gave a different result from searchEarliestOccurrence.\n", mismatches);
+    }
+
+    freeEytzingerIndex(&eytzinger);
+    freeSearchIndex(&index);
+    free(queries);
+    free(results);
+    return mismatches > 0;
+}
+
+// Function to list the logs of a product between two days, on one line or on all of them, through the time index
+// Prints one line per log in date and time order, then the number of logs; the query time is written to stderr
+int runRangeQuery(const struct LogStore *store, int productID, int lineCode, int from_date_time, int to_date_time)
+{
+    struct TimeIndex index;
+    double start = currentTimeMs();
+    TRACE_BEGIN(index);
+    if (!buildTimeIndex(&index, store))
+    {
+        return 1;
+    }
+    TRACE_END(index);
+    double index_ms = currentTimeMs() - start;
+
+    start = currentTimeMs();
+    TRACE_BEGIN(range);
+    struct TimeRangeCursor cursor;
+    int count = openTimeRange(&cursor, &index, productID, lineCode, from_date_time, to_date_time);
+    int row;
+    while ((row = nextTimeRange(&cursor)) != -1)
+    {
+        struct DateTime date_time = unpackDateTime(store->BatchDateTime[row]);
+        printf("Product ID: %d  Line Code: %d  Issue Code: %d  Index: %d  Date & Time: %d %d:%d\n", store->ProductId[row],
+               store->LineCode[row], store->IssueCode[row], row, date_time.dayofmonth, date_time.hourofday, date_time.minuteofhour);
+    }
+    TRACE_END(range);
+    double range_ms = currentTimeMs() - start;
+
+    struct DateTime from = unpackDateTime((uint16_t)from_date_time);
+    struct DateTime to = unpackDateTime((uint16_t)to_date_time);
+    if (lineCode == -1)
+    {
+        printf("%d issues for Product ID %d between day %d and day %d\n", count, productID, from.dayofmonth, to.dayofmonth);
+    }
+    else
+    {
+        printf("%d issues for Product ID %d on line %d between day %d and day %d\n", count, productID, lineCode, from.dayofmonth, to.dayofmonth);
+    }
+    fprintf(stderr, "Time index of %d logs built in %.3f ms, range listed in %.3f ms\n", store->size, index_ms, range_ms);
+
+    freeTimeIndex(&index);
+    return 0;
+}
+
+// Function to search every month of an archive for the earliest occurrence ever of an issue code for a product
+// Prints the month and log of the occurrence; the months searched and pruned and the query time are written to stderr
+int runArchiveSearch(const char *manifest_path, int productID, int issueCode)
+{
+    struct LogArchive archive;
+    if (!loadArchive(&archive, manifest_path, 0))
+    {
+        return 1;
+    }
+
+    int partition = -1;
+    int row = -1;
+    int searched = 0;
+    double start = currentTimeMs();
+    TRACE_BEGIN(search);
+    int found = archiveEarliestOccurrence(&archive, productID, issueCode, defaultThreadCount(), &partition, &row, &searched);
+    TRACE_END(search);
+    double search_ms = currentTimeMs() - start;
+
+    if (found == 1)
+    {
+        const struct LogStore *store = &archive.partitions[partition].store;
+        struct DateTime date_time = unpackDateTime(store->BatchDateTime[row]);
+        char month_text[16];
+        formatArchiveMonth(archive.partitions[partition].month, month_text);
+        printf("Earliest occurrence of Issue Code %d for Product ID %d found in %s at index %d\n", issueCode, productID, month_text, row);
+        printf("Production Line: %d\n", store->LineCode[row]);
+        printf("Batch Date & Time: %d (day of the month) %d:%d (time)\n", date_time.dayofmonth, date_time.hourofday, date_time.minuteofhour);
+    }
+    else if (found == 0)
+    {
+        printf("Issue Code %d not found for Product ID %d in the archive.\n", issueCode, productID);
+    }
+    fprintf(stderr, "Archive search: %d of %d months searched (%d pruned) in %.3f ms\n", searched, archive.count,
+            archive.count - searched, search_ms);
+
+    freeArchive(&archive);
+    return found < 0;
+}
+
+// Function to print the command line of the program
+void printSearchUsage(const char *program)
+{
+    printf("Usage: %s [--logs file.qalog [--index file.qaidx]] | batch query_file [rows | --logs file.qalog] | range product from_day to_day [line] [--logs file.qalog] | measure [rows] [queries] | archive manifest product issue\n", program);
 }
 
-int main()
+
+// Usage: task3_assignment [--logs file.qalog [--index file.qaidx]] | batch query_file [rows | --logs file.qalog] | range product from_day to_day [line] [--logs file.qalog] | measure [rows] [queries] | archive manifest product issue
+// Without arguments, search the example logs for a Product ID and Issue Code read from the keyboard
+// measure - time indexed lookups against a linear scan on a synthetic log (default 1000000 rows, 100000 queries)
+// batch   - answer every "ProductId IssueCode" line of query_file, against the example logs or a synthetic log of rows logs
+// range   - list the logs of a product from the start of from_day to the end of to_day, on one line or on all lines
+// archive - search every month of a log archive (see qa_archive.h) for the earliest occurrence of an issue code for a product
+// --logs  - search the logs of a binary log file instead of the example logs, in the search, batch and range modes
+// --index - search them through their B+-tree index file (see qa_log_index.h) instead of building an index, in the
+//           search read from the keyboard only
+int main(int argc, char *argv[])
 {
-    // Example ProductionLine_Log array
-    struct ProductionLine_Log logs_data[] =
+    const char *logs_path = takeLogsOption(&argc, argv);
+    const char *index_path = takeIndexOption(&argc, argv);
+    int batch_mode = argc > 2 && strcmp(argv[1], "batch") == 0;
+    int range_mode = argc > 1 && strcmp(argv[1], "range") == 0;
+    int archive_mode = argc == 5 && strcmp(argv[1], "archive") == 0;
+    int productID = 0;
+    int lineCode = -1;
+    int from_date_time = 0;
+    int to_date_time = 0;
+
+    if (index_path != NULL && logs_path == NULL)
+    {
+        printf("An index file is searched with the log file it was built from, given with --logs.\n");
+        return 1;
+    }
+
+    // Reject the options a mode would ignore: a synthetic log, the measure mode and the archive read no log file,
+    // and only the interactive search reads an index
+    int logs_unused = (batch_mode && argc > 3) || archive_mode || (argc > 1 && !batch_mode && !range_mode);
+    if ((index_path != NULL && argc > 1) || (logs_path != NULL && logs_unused))
+    {
+        printSearchUsage(argv[0]);
+        return 1;
+    }
+    if (archive_mode)
+    {
+        int status = runArchiveSearch(argv[2], atoi(argv[3]), atoi(argv[4]));
+        TRACE_DUMP();
+        return status;
+    }
+    if (range_mode && !parseTimeRangeArguments(argc - 2, argv + 2, &productID, &from_date_time, &to_date_time, &lineCode))
+    {
+        return 1;
+    }
+    if (argc > 1 && !batch_mode && !range_mode)
+    {
+        if (strcmp(argv[1], "measure") != 0)
+        {
+            printSearchUsage(argv[0]);
+            return 1;
+        }
+        int rows = argc > 2 ? atoi(argv[2]) : 1000000;
+        int queries = argc > 3 ? atoi(argv[3]) : 100000;
+        if (rows < 1 || queries < 1)
+        {
+            printf("Rows and queries must be at least 1.\n");
+            return 1;
+        }
+        int status = measureSearch(rows, queries);
+        TRACE_DUMP();
+        return status;
+    }
+
+    // Load the example QA logs or the log file given with --logs into the shared log store, or a synthetic log of the requested size in batch mode
+    struct LogStore store;
+    initLogStore(&store);
+
+    int loaded;
+    TRACE_BEGIN(load);
+    if (batch_mode && argc > 3)
+    {
+        int rows = atoi(argv[3]);
+        uint64_t random_state = 88172645463325252ULL;
+        if (rows < 1)
+        {
+            printf("Cannot create a synthetic log of %d rows.\n", rows);
+            return 1;
+        }
+        loaded = generateLogs(&store, rows, &random_state);
+    }
+    else
+    {
+        loaded = loadTaskLogs(&store, logs_path);
+    }
+
+    if (!loaded)
     {
-        {1, 101, {1, 20, 45}, 1001, 10, "Defect in wing", 10, "Resolved by replacing faulty component", 100},
-        {2, 102, {1, 5, 45}, 1003, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {5, 105, {1, 11, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 107, {1, 7, 45}, 1001, 1, "Product damage", 1, "Resolved by adding final quality checks", 100},
-        {9, 102, {1, 16, 45}, 1003, 3, "Shipping delay", 3, "Resolved by increasing number of couriers", 105},
-        {6, 103, {1, 23, 45}, 1005, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 111, {1, 10, 45}, 1001, 17, "Transportation issue", 17, "Resolved by improving transportation methods", 100},
-        {3, 116, {1, 6, 45}, 1006, 20, "Customer complaint", 20, "Resolved with personalised solutions", 105},
-        {1, 109, {1, 22, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {8, 107, {1, 21, 45}, 1005, 6, "Labelling issue", 6, "Resolved by implementing revised labelling procedures", 100},
-        {7, 112, {1, 18, 45}, 1001, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {1, 108, {1, 4, 45}, 1007, 30, "Staff shortage", 30, "Resolved by hiring temporary staff", 102},
-    };
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(load);
 
-    // Determine the number of logs in the array to ensure that the logs_number variable holds the correct number of logs, even if the size of the array changes in the future
-    int logs_number = sizeof(logs_data) / sizeof(logs_data[0]);
+    // Answer a whole query file in batch mode
+    if (batch_mode)
+    {
+        int status = runBatchQueries(&store, argv[2]);
+        freeLogStore(&store);
+        TRACE_DUMP();
+        return status;
+    }
 
-    int productID;
+    // Answer a time range query
+    if (range_mode)
+    {
+        int status = runRangeQuery(&store, productID, lineCode, from_date_time, to_date_time);
+        freeLogStore(&store);
+        TRACE_DUMP();
+        return status;
+    }
+
+    // Open the index file given with --index, or build the sorted search index once
+    struct SearchIndex index = {NULL, 0};
+    struct LogIndex log_index;
+    double start = currentTimeMs();
+    TRACE_BEGIN(index);
+    if (index_path != NULL ? !openLogIndex(&log_index, index_path, &store) : !buildSearchIndex(&index, &store))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(index);
+    if (index_path != NULL)
+    {
+        fprintf(stderr, "Opened index %s in %.3f ms\n", index_path, currentTimeMs() - start);
+    }
+
+    int issueCode;
     printf("Enter Product ID to search: ");
     scanf("%d", &productID);
+    printf("Enter Issue Code to search: ");
+    scanf("%d", &issueCode);
 
     // Perform binary search for earliest occurrence
-    int earliestIndex = searchEarliestOccurrence(logs_data, logs_number, productID);
+    TRACE_BEGIN(search);
+    int earliestIndex = -1;
+    int searched = 1;
+    if (index_path != NULL)
+    {
+        searched = searchLogIndex(&log_index, &store, productID, issueCode, &earliestIndex);
+    }
+    else
+    {
+        earliestIndex = searchEarliestOccurrence(&index, productID, issueCode);
+    }
+    TRACE_END(search);
 
     if (earliestIndex != -1)
     {
-        printf("Earliest occurrence of Product ID %d found at index %d\n", productID, earliestIndex);
-        printf("Related Issue Code: %d\n", logs_data[earliestIndex].IssueCode);
+        struct DateTime date_time = unpackDateTime(store.BatchDateTime[earliestIndex]);
+        printf("Earliest occurrence of Issue Code %d for Product ID %d found at index %d\n", issueCode, productID, earliestIndex);
+        printf("Production Line: %d\n", store.LineCode[earliestIndex]);
+        printf("Batch Date & Time: %d (day of the month) %d:%d (time)\n", date_time.dayofmonth, date_time.hourofday, date_time.minuteofhour);
     }
-    else
+    else if (searched)
     {
-        printf("Product ID %d not found in logs.\n", productID);
+        printf("Issue Code %d not found for Product ID %d in logs.\n", issueCode, productID);
     }
 
-    return 0;
+    if (index_path != NULL)
+    {
+        closeLogIndex(&log_index);
+    }
+    freeSearchIndex(&index);
+    freeLogStore(&store);
+    TRACE_DUMP();
+    return !searched;
 }
 
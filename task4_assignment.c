@@ -26,72 +26,944 @@ Beatrice Maria Giurgica
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 
-// Define DateTime structure
-struct DateTime
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define COUNT_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define COUNT_KERNELS_X86 0
+#endif
+
+#include "qa_log_store.h"
+#include "qa_log_file.h"
+#include "qa_log_csv.h"
+#include "qa_trace.h"
+#include "qa_time_index.h"
+#include "qa_archive.h"
+#include "qa_log_index.h"
+#include "qa_ingest.h"
+
+#include <pthread.h>
+
+// Function to perform linear search and count issues for a product ID
+int countIssues(const struct LogStore *store, int productID)
 {
-    int dayofmonth;
-    int hourofday;
-    int minuteofhour;
+    int count = 0;
+    for (int i = 0; i < store->size; i++)
+    {
+        if (store->ProductId[i] == productID)
+        {
+            count++;
+        }
+    }
+    TRACE_COUNT(TRACE_SCANS, store->size);
+    return count;
+}
+
+// Define an open-addressed hash table counting logs per 64-bit key
+// A slot is empty while its count is 0, so no separate occupancy flags are needed
+struct CountTable
+{
+    uint64_t *keys;
+    int *counts;
+    unsigned int capacity; // Always a power of two
+    unsigned int size;
 };
 
-// Define ProductionLine_Log structure
-struct ProductionLine_Log
+// Define one counted key taken out of a CountTable for reporting
+struct KeyCount
 {
-    int LineCode;
-    int BatchCode;
-    struct DateTime BatchDateTime;
     int ProductId;
-    int IssueCode;
-    char IssueDescription[100];
-    int ResolutionCode;
-    char ResolutionDescription[100];
-    int ReportingEmployeeId;
+    int SubCode; // Line Code or Issue Code of a breakdown, 0 for the product totals
+    int count;
 };
 
-// Function to perform linear search and count issues for a product ID
-int countIssues(struct ProductionLine_Log logs_data[], int num_logs, int productID)
+// Define the per-product summary built in one pass over the logs
+struct IssueSummary
 {
-    int count = 0;
-    for (int i = 0; i < num_logs; i++)
+    struct CountTable products;
+    struct CountTable product_lines;  // Used when the Line Code breakdown is requested
+    struct CountTable product_issues; // Used when the Issue Code breakdown is requested
+    int by_line;
+    int by_issue;
+};
+
+// Define a kernel counting the values of a column equal to a target, chosen at runtime
+struct CountKernel
+{
+    const char *name;
+    int (*count)(const int32_t values[], int size, int32_t target);
+};
+
+// Define a simulated production line of the ingestion load generator
+struct LineProducer
+{
+    struct LogIngest *ingest;
+    int line;             // Ring of the line; its Line Code is line + 1
+    int logs_number;
+    uint64_t random_state;
+    long long product_sum; // Sum of the Product IDs pushed, to check that none was lost
+    int pushed;
+};
+
+// Initial number of slots of a count table
+#define COUNT_TABLE_INITIAL_CAPACITY 1024
+
+// Production lines simulated by the ingest mode, and the longest burst of logs a line pushes without pausing
+#define INGEST_LINES 4
+#define INGEST_MAX_BURST (2 * INGEST_RING_CAPACITY)
+
+
+// Function to pack a Product ID and a Line Code or Issue Code into one table key
+uint64_t packCountKey(int productID, int subCode)
+{
+    return ((uint64_t)(uint32_t)productID << 32) | (uint32_t)subCode;
+}
+
+
+// Function to find the slot of key, or the empty slot where it belongs
+unsigned int findCountSlot(const struct CountTable *table, uint64_t key)
+{
+    unsigned int slot = (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (table->capacity - 1);
+
+    // Linear probing until the key or an empty slot is found
+    TRACE_COUNT(TRACE_PROBES, 1);
+    while (table->counts[slot] != 0 && table->keys[slot] != key)
+    {
+        slot = (slot + 1) & (table->capacity - 1);
+        TRACE_COUNT(TRACE_PROBES, 1);
+    }
+    return slot;
+}
+
+
+// Function to allocate an empty count table of the given capacity (a power of two)
+// Returns 0 if memory could not be allocated
+int initCountTable(struct CountTable *table, unsigned int capacity)
+{
+    table->keys = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+    table->counts = (int *)calloc(capacity, sizeof(int));
+    table->capacity = capacity;
+    table->size = 0;
+
+    if (table->keys == NULL || table->counts == NULL)
+    {
+        free(table->keys);
+        free(table->counts);
+        table->keys = NULL;
+        table->counts = NULL;
+        return 0;
+    }
+    TRACE_COUNT(TRACE_ALLOCATIONS, 2);
+    return 1;
+}
+
+
+// Function to release a count table
+void freeCountTable(struct CountTable *table)
+{
+    free(table->keys);
+    free(table->counts);
+    table->keys = NULL;
+    table->counts = NULL;
+    table->capacity = 0;
+    table->size = 0;
+}
+
+
+// Function to double the capacity of a count table and rehash its keys
+int growCountTable(struct CountTable *table)
+{
+    struct CountTable grown;
+    if (!initCountTable(&grown, table->capacity * 2))
     {
-        if (logs_data[i].ProductId == productID)
+        return 0;
+    }
+
+    for (unsigned int slot = 0; slot < table->capacity; slot++)
+    {
+        if (table->counts[slot] != 0)
         {
-            count++;
+            unsigned int target = findCountSlot(&grown, table->keys[slot]);
+            grown.keys[target] = table->keys[slot];
+            grown.counts[target] = table->counts[slot];
         }
     }
+    TRACE_COUNT(TRACE_MOVES, table->size);
+    grown.size = table->size;
+
+    freeCountTable(table);
+    *table = grown;
+    return 1;
+}
+
+
+// Function to add one to the count of key
+// Returns 0 if the table needed to grow and memory could not be allocated
+int incrementCount(struct CountTable *table, uint64_t key)
+{
+    unsigned int slot = findCountSlot(table, key);
+
+    if (table->counts[slot] == 0)
+    {
+        // Keep the table at most half full so probe sequences stay short
+        if (2 * (table->size + 1) > table->capacity)
+        {
+            if (!growCountTable(table))
+            {
+                return 0;
+            }
+            slot = findCountSlot(table, key);
+        }
+        table->keys[slot] = key;
+        table->size++;
+    }
+    table->counts[slot]++;
+    return 1;
+}
+
+
+// Function to release the tables of a summary
+void freeIssueSummary(struct IssueSummary *summary)
+{
+    freeCountTable(&summary->products);
+    freeCountTable(&summary->product_lines);
+    freeCountTable(&summary->product_issues);
+}
+
+
+// Function to add log row of the store to the counts of a summary in amortised O(1)
+// Returns 0 if memory could not be allocated
+int countSummaryLog(struct IssueSummary *summary, const struct LogStore *store, int row)
+{
+    int productID = store->ProductId[row];
+
+    return incrementCount(&summary->products, packCountKey(productID, 0)) &&
+           (!summary->by_line || incrementCount(&summary->product_lines, packCountKey(productID, store->LineCode[row]))) &&
+           (!summary->by_issue || incrementCount(&summary->product_issues, packCountKey(productID, store->IssueCode[row])));
+}
+
+
+// Function to bring a summary up to date with a log just appended to the store (LogAppendFunction)
+int appendSummaryLog(void *summary, const struct LogStore *store, int row)
+{
+    return countSummaryLog((struct IssueSummary *)summary, store, row);
+}
+
+
+// Function to count the issues of every product, and optionally of every (product, line) and (product, issue code)
+// pair, in a single pass over the Product ID, Line Code and Issue Code columns of the store in O(N)
+// Returns 0 if memory could not be allocated
+int buildIssueSummary(struct IssueSummary *summary, const struct LogStore *store, int by_line, int by_issue)
+{
+    memset(summary, 0, sizeof(struct IssueSummary));
+    summary->by_line = by_line;
+    summary->by_issue = by_issue;
+
+    int ok = initCountTable(&summary->products, COUNT_TABLE_INITIAL_CAPACITY) &&
+             (!by_line || initCountTable(&summary->product_lines, COUNT_TABLE_INITIAL_CAPACITY)) &&
+             (!by_issue || initCountTable(&summary->product_issues, COUNT_TABLE_INITIAL_CAPACITY));
+
+    for (int i = 0; ok && i < store->size; i++)
+    {
+        ok = countSummaryLog(summary, store, i);
+    }
+
+    if (!ok)
+    {
+        printf("Memory allocation failed.\n");
+        freeIssueSummary(summary);
+    }
+    return ok;
+}
+
+
+// qsort comparison ordering counted keys by Product ID, then by Line Code or Issue Code
+int compareKeyCounts(const void *a, const void *b)
+{
+    const struct KeyCount *left = (const struct KeyCount *)a;
+    const struct KeyCount *right = (const struct KeyCount *)b;
+    TRACE_COUNT(TRACE_COMPARISONS, 1);
+
+    if (left->ProductId != right->ProductId)
+    {
+        return left->ProductId < right->ProductId ? -1 : 1;
+    }
+    return (left->SubCode > right->SubCode) - (left->SubCode < right->SubCode);
+}
+
+
+// Function to copy the counts of a table into an array sorted by Product ID and sub code
+// Returns the array (to be freed by the caller), or NULL if memory could not be allocated
+struct KeyCount *sortedCounts(const struct CountTable *table)
+{
+    struct KeyCount *counts = (struct KeyCount *)malloc((table->size > 0 ? table->size : 1) * sizeof(struct KeyCount));
+    if (counts == NULL)
+    {
+        return NULL;
+    }
+
+    unsigned int taken = 0;
+    for (unsigned int slot = 0; slot < table->capacity; slot++)
+    {
+        if (table->counts[slot] != 0)
+        {
+            counts[taken].ProductId = (int)(uint32_t)(table->keys[slot] >> 32);
+            counts[taken].SubCode = (int)(uint32_t)table->keys[slot];
+            counts[taken].count = table->counts[slot];
+            taken++;
+        }
+    }
+
+    qsort(counts, taken, sizeof(struct KeyCount), compareKeyCounts);
+    return counts;
+}
+
+
+// Function to print the issues per product across all production lines, with the requested breakdowns under each product
+int printIssueSummary(const struct IssueSummary *summary)
+{
+    struct KeyCount *products = sortedCounts(&summary->products);
+    struct KeyCount *lines = summary->by_line ? sortedCounts(&summary->product_lines) : NULL;
+    struct KeyCount *issues = summary->by_issue ? sortedCounts(&summary->product_issues) : NULL;
+
+    if (products == NULL || (summary->by_line && lines == NULL) || (summary->by_issue && issues == NULL))
+    {
+        printf("Memory allocation failed.\n");
+        free(products);
+        free(lines);
+        free(issues);
+        return 0;
+    }
+
+    printf("Issues per Product Across All Production Lines:\n");
+
+    // The breakdown arrays are sorted by Product ID too, so they are walked alongside the products
+    unsigned int line = 0;
+    unsigned int issue = 0;
+    for (unsigned int p = 0; p < summary->products.size; p++)
+    {
+        printf("Product ID: %d  Issues: %d\n", products[p].ProductId, products[p].count);
+
+        for (; summary->by_line && line < summary->product_lines.size && lines[line].ProductId == products[p].ProductId; line++)
+        {
+            printf("    Line Code: %d  Issues: %d\n", lines[line].SubCode, lines[line].count);
+        }
+        for (; summary->by_issue && issue < summary->product_issues.size && issues[issue].ProductId == products[p].ProductId; issue++)
+        {
+            printf("    Issue Code: %d  Issues: %d\n", issues[issue].SubCode, issues[issue].count);
+        }
+    }
+
+    free(products);
+    free(lines);
+    free(issues);
+    return 1;
+}
+
+
+// Scalar kernel counting the values equal to target; also finishes the tails of the vector kernels
+int countMatchesScalar(const int32_t values[], int size, int32_t target)
+{
+    int count = 0;
+    for (int i = 0; i < size; i++)
+    {
+        count += values[i] == target;
+    }
     return count;
 }
 
-int main()
+
+#if COUNT_KERNELS_X86
+// SSE2 kernel: compares 4 values at a time
+// A matching lane compares to -1, so subtracting the comparison adds one to that lane's count
+__attribute__((target("sse2")))
+int countMatchesSse2(const int32_t values[], int size, int32_t target)
+{
+    __m128i wanted = _mm_set1_epi32(target);
+    __m128i lane_counts = _mm_setzero_si128();
+    int i = 0;
+
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(values + i));
+        lane_counts = _mm_sub_epi32(lane_counts, _mm_cmpeq_epi32(block, wanted));
+    }
+
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, lane_counts);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + countMatchesScalar(values + i, size - i, target);
+}
+
+
+// AVX2 kernel: compares 32 values per iteration in four independent accumulators
+__attribute__((target("avx2")))
+int countMatchesAvx2(const int32_t values[], int size, int32_t target)
+{
+    __m256i wanted = _mm256_set1_epi32(target);
+    __m256i counts0 = _mm256_setzero_si256();
+    __m256i counts1 = _mm256_setzero_si256();
+    __m256i counts2 = _mm256_setzero_si256();
+    __m256i counts3 = _mm256_setzero_si256();
+    int i = 0;
+
+    for (; i + 32 <= size; i += 32)
+    {
+        counts0 = _mm256_sub_epi32(counts0, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i)), wanted));
+        counts1 = _mm256_sub_epi32(counts1, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i + 8)), wanted));
+        counts2 = _mm256_sub_epi32(counts2, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i + 16)), wanted));
+        counts3 = _mm256_sub_epi32(counts3, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i + 24)), wanted));
+    }
+
+    __m256i total = _mm256_add_epi32(_mm256_add_epi32(counts0, counts1), _mm256_add_epi32(counts2, counts3));
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, total);
+
+    int count = 0;
+    for (int lane = 0; lane < 8; lane++)
+    {
+        count += lanes[lane];
+    }
+    return count + countMatchesScalar(values + i, size - i, target);
+}
+#endif
+
+
+// Function to choose the fastest counting kernel the processor supports
+struct CountKernel selectCountKernel(void)
 {
-    // Example ProductionLine_Log array
-    struct ProductionLine_Log logs_data[] =
+#if COUNT_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return (struct CountKernel){"avx2", countMatchesAvx2};
+    }
+    if (__builtin_cpu_supports("sse2"))
     {
-        {1, 101, {1, 20, 45}, 1001, 10, "Defect in wing", 10, "Resolved by replacing faulty component", 100},
-        {2, 102, {1, 5, 45}, 1003, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {5, 105, {1, 11, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 107, {1, 7, 45}, 1001, 1, "Product damage", 1, "Resolved by adding final quality checks", 100},
-        {9, 102, {1, 16, 45}, 1003, 3, "Shipping delay", 3, "Resolved by increasing number of couriers", 105},
-        {6, 103, {1, 23, 45}, 1005, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {1, 111, {1, 10, 45}, 1001, 17, "Transportation issue", 17, "Resolved by improving transportation methods", 100},
-        {3, 116, {1, 6, 45}, 1006, 20, "Customer complaint", 20, "Resolved with personalised solutions", 105},
-        {1, 109, {1, 22, 45}, 1002, 15, "Engine malfunction", 15, "Resolved by replacing affected parts", 102},
-        {8, 107, {1, 21, 45}, 1005, 6, "Labelling issue", 6, "Resolved by implementing revised labelling procedures", 100},
-        {7, 112, {1, 18, 45}, 1001, 12, "Fire detection system malfunction", 12, "Resolved by conducting system testing", 105},
-        {1, 108, {1, 4, 45}, 1007, 30, "Staff shortage", 30, "Resolved by hiring temporary staff", 102},
-    };
+        return (struct CountKernel){"sse2", countMatchesSse2};
+    }
+#endif
+    return (struct CountKernel){"scalar", countMatchesScalar};
+}
+
+
+// Function to count issues for a product ID over the ProductId column of the store with the selected kernel
+// Gives the same result as countIssues()
+int countIssuesColumnar(const struct LogStore *store, struct CountKernel kernel, int productID)
+{
+    TRACE_COUNT(TRACE_SCANS, store->size);
+    return kernel.count(store->ProductId, store->size, productID);
+}
 
-    // Determine the number of logs in the array to ensure that the logs_number variable holds the correct number of logs, even if the size of the array changes in the future
-    int logs_number = sizeof(logs_data) / sizeof(logs_data[0]);
 
-    int productID;
+// Function to measure the single-pass summary against calling countIssues() once per product on a synthetic log
+int measureSummary(int logs_number)
+{
+    uint64_t random_state = 88172645463325252ULL;
+    struct LogStore store;
+    initLogStore(&store);
+    if (!generateLogs(&store, logs_number, &random_state))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+
+    struct IssueSummary summary;
+    double start = currentTimeMs();
+    TRACE_BEGIN(summary);
+    if (!buildIssueSummary(&summary, &store, 0, 0))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(summary);
+    double summary_ms = currentTimeMs() - start;
+    printf("Single-pass summary: %d logs, %u products in %.3f ms (%.0f rows per second)\n",
+           logs_number, summary.products.size, summary_ms, summary_ms > 0 ? logs_number * 1000.0 / summary_ms : 0.0);
+
+    // Count every product again with one countIssues() scan each and check both agree
+    int mismatches = 0;
+    start = currentTimeMs();
+    TRACE_BEGIN(count);
+    for (unsigned int slot = 0; slot < summary.products.capacity; slot++)
+    {
+        if (summary.products.counts[slot] != 0)
+        {
+            int productID = (int)(uint32_t)(summary.products.keys[slot] >> 32);
+            mismatches += countIssues(&store, productID) != summary.products.counts[slot];
+        }
+    }
+    TRACE_END(count);
+    double scan_ms = currentTimeMs() - start;
+    printf("countIssues per product: %u scans in %.3f ms (%.0f rows per second)\n",
+           summary.products.size, scan_ms, scan_ms > 0 ? (double)logs_number * summary.products.size * 1000.0 / scan_ms : 0.0);
+
+    // Count every product again over the ProductId column with the vector kernel
+    struct CountKernel kernel = selectCountKernel();
+    start = currentTimeMs();
+    TRACE_BEGIN(columnar);
+    for (unsigned int slot = 0; slot < summary.products.capacity; slot++)
+    {
+        if (summary.products.counts[slot] != 0)
+        {
+            int productID = (int)(uint32_t)(summary.products.keys[slot] >> 32);
+            mismatches += countIssuesColumnar(&store, kernel, productID) != summary.products.counts[slot];
+        }
+    }
+    TRACE_END(columnar);
+    double columnar_ms = currentTimeMs() - start;
+    printf("countIssuesColumnar (%s) per product: %u scans in %.3f ms (%.0f rows per second)\n", kernel.name,
+           summary.products.size, columnar_ms, columnar_ms > 0 ? (double)logs_number * summary.products.size * 1000.0 / columnar_ms : 0.0);
+
+    if (mismatches > 0)
+    {
+        printf("%d counts differ between the summary, countIssues and countIssuesColumnar.\n", mismatches);
+    }
+
+    freeIssueSummary(&summary);
+    freeLogStore(&store);
+    return mismatches > 0;
+}
+
+// Function to count the issues of a product between two days, on one line or on all of them, through the time index
+// The count takes two binary searches and no scan; the index and query times are written to stderr
+int printRangeCount(const struct LogStore *store, int productID, int lineCode, int from_date_time, int to_date_time)
+{
+    struct TimeIndex index;
+    double start = currentTimeMs();
+    TRACE_BEGIN(index);
+    if (!buildTimeIndex(&index, store))
+    {
+        return 0;
+    }
+    TRACE_END(index);
+    double index_ms = currentTimeMs() - start;
+
+    start = currentTimeMs();
+    TRACE_BEGIN(count);
+    int issue_count = countTimeRange(&index, productID, lineCode, from_date_time, to_date_time);
+    TRACE_END(count);
+    double count_ms = currentTimeMs() - start;
+
+    struct DateTime from = unpackDateTime((uint16_t)from_date_time);
+    struct DateTime to = unpackDateTime((uint16_t)to_date_time);
+    if (lineCode == -1)
+    {
+        printf("Number of issues for Product ID %d between day %d and day %d: %d\n", productID, from.dayofmonth, to.dayofmonth, issue_count);
+    }
+    else
+    {
+        printf("Number of issues for Product ID %d on line %d between day %d and day %d: %d\n", productID, lineCode, from.dayofmonth, to.dayofmonth, issue_count);
+    }
+    fprintf(stderr, "Time index of %d logs built in %.3f ms, range counted in %.3f ms\n", store->size, index_ms, count_ms);
+
+    freeTimeIndex(&index);
+    return 1;
+}
+
+// Function to count the issues of a product in every month of an archive, or in months first_month to last_month
+// Prints the count of each month searched and the total; the months searched and pruned and the query time are written to stderr
+int printArchiveCount(const char *manifest_path, int productID, int first_month, int last_month)
+{
+    struct LogArchive archive;
+    if (!loadArchive(&archive, manifest_path, 0))
+    {
+        return 0;
+    }
+    int *month_counts = (int *)malloc((size_t)(archive.count > 0 ? archive.count : 1) * sizeof(int));
+    if (month_counts == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        freeArchive(&archive);
+        return 0;
+    }
+
+    int searched = 0;
+    double start = currentTimeMs();
+    TRACE_BEGIN(count);
+    long long total = archiveCountIssues(&archive, productID, first_month, last_month, defaultThreadCount(), month_counts, &searched);
+    TRACE_END(count);
+    double count_ms = currentTimeMs() - start;
+
+    if (total >= 0)
+    {
+        for (int p = 0; p < archive.count; p++)
+        {
+            if (month_counts[p] > 0)
+            {
+                char month_text[16];
+                formatArchiveMonth(archive.partitions[p].month, month_text);
+                printf("%s: %d issues\n", month_text, month_counts[p]);
+            }
+        }
+        printf("Total issues for Product ID %d in the archive: %lld\n", productID, total);
+    }
+    fprintf(stderr, "Archive count: %d of %d months searched (%d pruned) in %.3f ms\n", searched, archive.count,
+            archive.count - searched, count_ms);
+
+    free(month_counts);
+    freeArchive(&archive);
+    return total >= 0;
+}
+
+// Function to run one production line of the ingestion load generator on its own thread
+// The line pushes its logs in bursts of random length, up to twice its ring, with a short pause after each
+void *runLineProducer(void *argument)
+{
+    struct LineProducer *producer = (struct LineProducer *)argument;
+    struct ProductionLine_Log log;
+
+    while (producer->pushed < producer->logs_number)
+    {
+        int burst = 1 + (int)(nextRandom(&producer->random_state) % INGEST_MAX_BURST);
+        for (int i = 0; i < burst && producer->pushed < producer->logs_number; i++)
+        {
+            generateLog(&log, &producer->random_state);
+            log.LineCode = producer->line + 1;
+            if (!pushLogIngest(producer->ingest, producer->line, &log))
+            {
+                return NULL;
+            }
+            producer->product_sum += log.ProductId;
+            producer->pushed++;
+        }
+
+        int pause = (int)(nextRandom(&producer->random_state) % 16);
+        for (int i = 0; i < pause; i++)
+        {
+            ingestYield();
+        }
+    }
+    finishLogProducer(producer->ingest);
+    return NULL;
+}
+
+
+// Function to count the keys of expected whose count differs in actual
+int countTableMismatches(const struct CountTable *expected, const struct CountTable *actual)
+{
+    int mismatches = expected->size != actual->size;
+    for (unsigned int slot = 0; slot < expected->capacity; slot++)
+    {
+        if (expected->counts[slot] != 0)
+        {
+            mismatches += actual->counts[findCountSlot(actual, expected->keys[slot])] != expected->counts[slot];
+        }
+    }
+    return mismatches;
+}
+
+
+// Function to measure concurrent ingestion: INGEST_LINES producer threads push logs_per_line logs each into their
+// rings while this thread appends them to a log store and counts them into a summary by product and line
+// Every log pushed must come out in the store and the summary, which must match one built afterwards from the store
+int measureIngest(int logs_per_line)
+{
+    struct LogIngest ingest;
+    if (!initLogIngest(&ingest, INGEST_LINES))
+    {
+        return 1;
+    }
+    struct LogStore store;
+    struct IssueSummary summary;
+    initLogStore(&store);
+    if (!buildIssueSummary(&summary, &store, 1, 0))
+    {
+        freeLogIngest(&ingest);
+        return 1;
+    }
+
+    pthread_t threads[INGEST_LINES];
+    struct LineProducer producers[INGEST_LINES];
+    int started = 0;
+    double start = currentTimeMs();
+    for (int l = 0; l < INGEST_LINES; l++)
+    {
+        producers[l].ingest = &ingest;
+        producers[l].line = l;
+        producers[l].logs_number = logs_per_line;
+        producers[l].random_state = 88172645463325252ULL + 7919ULL * (uint64_t)l;
+        producers[l].product_sum = 0;
+        producers[l].pushed = 0;
+        if (pthread_create(&threads[l], NULL, runLineProducer, &producers[l]) != 0)
+        {
+            printf("Could not start the producer of line %d.\n", l + 1);
+            break;
+        }
+        started++;
+    }
+
+    TRACE_BEGIN(append);
+    int consumed = started == INGEST_LINES && consumeLogIngest(&ingest, &store, appendSummaryLog, &summary);
+    TRACE_END(append);
+    if (started < INGEST_LINES)
+    {
+        atomic_store(&ingest.consumer_failed, 1);
+    }
+    for (int l = 0; l < started; l++)
+    {
+        pthread_join(threads[l], NULL);
+    }
+    double ingest_ms = currentTimeMs() - start;
+
+    int mismatches = 0;
+    if (consumed)
+    {
+        // Every line must have delivered all of its logs, and the streamed summary must match a rebuilt one
+        uint64_t full_waits = 0;
+        long long line_sums[INGEST_LINES] = {0};
+        int line_counts[INGEST_LINES] = {0};
+        for (int i = 0; i < store.size; i++)
+        {
+            int line = store.LineCode[i] - 1;
+            line_sums[line] += store.ProductId[i];
+            line_counts[line]++;
+        }
+        for (int l = 0; l < INGEST_LINES; l++)
+        {
+            mismatches += line_counts[l] != producers[l].pushed || line_sums[l] != producers[l].product_sum ||
+                          producers[l].pushed != logs_per_line;
+            full_waits += ingest.rings[l].full_waits;
+        }
+
+        struct IssueSummary rebuilt;
+        if (buildIssueSummary(&rebuilt, &store, 1, 0))
+        {
+            mismatches += countTableMismatches(&rebuilt.products, &summary.products) +
+                          countTableMismatches(&rebuilt.product_lines, &summary.product_lines);
+            freeIssueSummary(&rebuilt);
+        }
+
+        printf("Ingested %d logs from %d lines in %.3f ms (%.0f logs per second)\n", store.size, INGEST_LINES,
+               ingest_ms, ingest_ms > 0 ? store.size * 1000.0 / ingest_ms : 0.0);
+        printf("Producers waited on a full ring %llu times; %u products counted\n", (unsigned long long)full_waits, summary.products.size);
+        if (mismatches > 0)
+        {
+            printf("%d lines or counts differ from the logs pushed.\n", mismatches);
+        }
+    }
+
+    freeIssueSummary(&summary);
+    freeLogStore(&store);
+    freeLogIngest(&ingest);
+    return !consumed || mismatches > 0;
+}
+
+// Function to print the command line of the program
+void printCountUsage(const char *program)
+{
+    printf("Usage: %s [columnar] [--logs file.qalog] | --logs file.qalog --index file.qaidx | summary [lines] [issues] [append new.csv] [--logs file.qalog] | range product from_day to_day [line] [--logs file.qalog] | measure [rows] | archive manifest product [first_month last_month] | ingest [logs_per_line]\n", program);
+}
+
+
+// Usage: task4_assignment [columnar] [--logs file.qalog] | --logs file.qalog --index file.qaidx
+//                         | summary [lines] [issues] [append new.csv] [--logs file.qalog] | range product from_day to_day [line] [--logs file.qalog]
+//                         | measure [rows] | archive manifest product [first_month last_month] | ingest [logs_per_line]
+// Without arguments, count the issues of a Product ID read from the keyboard
+// columnar - count the issues of a Product ID read from the keyboard with the vector kernel
+// summary - report the issues of every product in one pass, optionally broken down by Line Code and/or Issue Code;
+//           with append, the logs of new.csv ("-" for standard input) are then counted in one by one as they arrive
+// range   - count the issues of a product from the start of from_day to the end of to_day, on one line or on all lines
+// archive - count the issues of a product in every month of a log archive (see qa_archive.h), or from first_month to
+//           last_month (YYYY-MM)
+// measure - time the single-pass summary against per-product countIssues() scans on a synthetic log (default 1000000 rows)
+// ingest  - measure concurrent ingestion from 4 simulated production lines through lock-free rings (see qa_ingest.h),
+//           counting the logs into a summary as they arrive (default 1000000 logs per line)
+// --logs   - count the logs of a binary log file instead of the example logs, in the count, columnar, summary and range
+//            modes
+// --index  - count a Product ID read from the keyboard through the B+-tree index file of the logs (see qa_log_index.h)
+//            instead of scanning them, in the plain count only
+int main(int argc, char *argv[])
+{
+    const char *logs_path = takeLogsOption(&argc, argv);
+    const char *index_path = takeIndexOption(&argc, argv);
+    const char *mode = argc > 1 ? argv[1] : "count";
+    int by_line = 0;
+    int by_issue = 0;
+    const char *append_path = NULL;
+    int productID = 0;
+    int lineCode = -1;
+    int from_date_time = 0;
+    int to_date_time = 0;
+
+    if (index_path != NULL && logs_path == NULL)
+    {
+        printf("An index file is counted with the log file it was built from, given with --logs.\n");
+        return 1;
+    }
+
+    // Reject the options a mode would ignore: the measure, ingest and archive modes read no log file, and only the
+    // plain count reads an index
+    int logs_unused = strcmp(mode, "measure") == 0 || strcmp(mode, "ingest") == 0 || strcmp(mode, "archive") == 0;
+    if ((index_path != NULL && argc > 1) || (logs_path != NULL && logs_unused))
+    {
+        printCountUsage(argv[0]);
+        return 1;
+    }
+    if (strcmp(mode, "measure") == 0)
+    {
+        int rows = argc > 2 ? atoi(argv[2]) : 1000000;
+        if (rows < 1)
+        {
+            printf("Rows must be at least 1.\n");
+            return 1;
+        }
+        int status = measureSummary(rows);
+        TRACE_DUMP();
+        return status;
+    }
+    else if (strcmp(mode, "ingest") == 0)
+    {
+        int logs_per_line = argc > 2 ? atoi(argv[2]) : 1000000;
+        if (logs_per_line < 1 || logs_per_line > INT32_MAX / INGEST_LINES)
+        {
+            printf("Logs per line must be from 1 to %d.\n", INT32_MAX / INGEST_LINES);
+            return 1;
+        }
+        int status = measureIngest(logs_per_line);
+        TRACE_DUMP();
+        return status;
+    }
+    else if (strcmp(mode, "archive") == 0 && (argc == 4 || argc == 6))
+    {
+        int first_month = argc == 6 ? parseArchiveMonth(argv[4]) : INT_MIN;
+        int last_month = argc == 6 ? parseArchiveMonth(argv[5]) : INT_MAX;
+        if (argc == 6 && (first_month < 0 || last_month < first_month))
+        {
+            printf("Months must be written YYYY-MM, the first not after the last.\n");
+            return 1;
+        }
+        int counted = printArchiveCount(argv[2], atoi(argv[3]), first_month, last_month);
+        TRACE_DUMP();
+        return !counted;
+    }
+    else if (strcmp(mode, "summary") == 0)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            by_line |= strcmp(argv[i], "lines") == 0;
+            by_issue |= strcmp(argv[i], "issues") == 0;
+            if (strcmp(argv[i], "append") == 0 && i + 1 < argc)
+            {
+                append_path = argv[++i];
+            }
+        }
+    }
+    else if (strcmp(mode, "range") == 0)
+    {
+        if (!parseTimeRangeArguments(argc - 2, argv + 2, &productID, &from_date_time, &to_date_time, &lineCode))
+        {
+            return 1;
+        }
+    }
+    else if (argc > 1 && strcmp(mode, "columnar") != 0)
+    {
+        printCountUsage(argv[0]);
+        return 1;
+    }
+
+    // Load the example QA logs, or the log file given with --logs, into the shared log store
+    struct LogStore store;
+    initLogStore(&store);
+    TRACE_BEGIN(load);
+    if (!loadTaskLogs(&store, logs_path))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(load);
+    int logs_number = store.size;
+
+    // Count the issues of one product within a time range
+    if (strcmp(mode, "range") == 0)
+    {
+        int counted = printRangeCount(&store, productID, lineCode, from_date_time, to_date_time);
+        freeLogStore(&store);
+        TRACE_DUMP();
+        return !counted;
+    }
+
+    // Report every product at once in summary mode
+    if (strcmp(mode, "summary") == 0)
+    {
+        struct IssueSummary summary;
+        double start = currentTimeMs();
+        TRACE_BEGIN(summary);
+        if (!buildIssueSummary(&summary, &store, by_line, by_issue))
+        {
+            freeLogStore(&store);
+            return 1;
+        }
+        TRACE_END(summary);
+        double summary_ms = currentTimeMs() - start;
+        fprintf(stderr, "Summary of %d logs built in %.3f ms (%.0f rows per second)\n",
+                logs_number, summary_ms, summary_ms > 0 ? logs_number * 1000.0 / summary_ms : 0.0);
+
+        // Count the new logs into the summary as they arrive instead of rebuilding it
+        TRACE_BEGIN(append);
+        if (append_path != NULL && !appendCsvLogs(&store, append_path, appendSummaryLog, &summary))
+        {
+            freeIssueSummary(&summary);
+            freeLogStore(&store);
+            return 1;
+        }
+        TRACE_END(append);
+
+        TRACE_BEGIN(report);
+        int printed = printIssueSummary(&summary);
+        TRACE_END(report);
+
+        freeIssueSummary(&summary);
+        freeLogStore(&store);
+        TRACE_DUMP();
+        return !printed;
+    }
+
+    // Open the index file given with --index
+    struct LogIndex log_index;
+    double start = currentTimeMs();
+    TRACE_BEGIN(index);
+    if (index_path != NULL && !openLogIndex(&log_index, index_path, &store))
+    {
+        freeLogStore(&store);
+        return 1;
+    }
+    TRACE_END(index);
+    if (index_path != NULL)
+    {
+        fprintf(stderr, "Opened index %s in %.3f ms\n", index_path, currentTimeMs() - start);
+    }
+
     printf("Enter Product ID to count issues: ");
     scanf("%d", &productID);
 
-    // Perform linear search and count issues for the given Product ID
-    int issue_count = countIssues(logs_data, logs_number, productID);
+    // Count issues for the given Product ID through the index, or with a linear search
+    int issue_count = 0;
+    int counted = 1;
+    TRACE_BEGIN(count);
+    if (index_path != NULL)
+    {
+        counted = countLogIndex(&log_index, productID, &issue_count);
+        closeLogIndex(&log_index);
+    }
+    else if (strcmp(mode, "columnar") == 0)
+    {
+        issue_count = countIssuesColumnar(&store, selectCountKernel(), productID);
+    }
+    else
+    {
+        issue_count = countIssues(&store, productID);
+    }
+    TRACE_END(count);
 
+    if (!counted)
+    {
+        freeLogStore(&store);
+        return 1;
+    }
     if (issue_count > 0)
     {
         printf("Number of issues for Product ID %d: %d\n", productID, issue_count);
@@ -101,5 +973,8 @@ int main()
         printf("No issues found for Product ID %d.\n", productID);
     }
 
+    freeLogStore(&store);
+    TRACE_DUMP();
+
     return 0;
 }